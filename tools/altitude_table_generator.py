@@ -0,0 +1,116 @@
+#!/usr/bin/env python
+
+import sys, argparse, os, math
+
+# Same constants as BME280calcAltitude() in vario/src/hardware/bme280/bme280.cpp
+SEA_LEVEL_PRESSURE = 101325.0
+HYPSOMETRIC_F_POW = 0.190295
+ALTITUDE_MULT = 44330.0
+
+arg_parser = argparse.ArgumentParser()
+
+arg_parser.add_argument('--output', '-o')
+arg_parser.add_argument('--min', '-n', type=int)
+arg_parser.add_argument('--max', '-x', type=int)
+arg_parser.add_argument('--step', '-s', type=int)
+
+args = arg_parser.parse_args()
+
+output = "bme280_altitude_table.h"
+if args.output:
+	output = args.output
+
+# pressure range to cover in Pa
+p_min = 30000
+if args.min:
+	p_min = args.min
+
+p_max = 110000
+if args.max:
+	p_max = args.max
+
+# node step as power of 2 in Pa
+step_log2 = 10
+if args.step:
+	step_log2 = args.step
+
+step = 1 << step_log2
+
+
+def altitude(pressure):
+	return ALTITUDE_MULT * (1.0 - math.pow(pressure / SEA_LEVEL_PRESSURE, HYPSOMETRIC_F_POW))
+
+def to_q16(value):
+	return int(round(value * 65536))
+
+
+start = (p_min >> step_log2) << step_log2
+# quadratic interpolation reads nodes i, i+1, i+2
+nodes = ((p_max - start) >> step_log2) + 3
+
+table = [to_q16(altitude(start + n * step)) for n in range(nodes)]
+
+
+def interpolate(pressure):
+	x = (pressure - start) / step
+	i = min(max(int(x), 0), nodes - 3)
+	u = x - i
+	h0, h1, h2 = table[i], table[i + 1], table[i + 2]
+	d1 = h1 - h0
+	d2 = h2 - 2 * h1 + h0
+	return (h0 + u * (d1 + (u - 1) * d2 / 2)) / 65536
+
+
+# accuracy sweep over the covered range, 1 Pa steps
+max_error = 0.0
+max_error_pressure = p_min
+for pressure in range(p_min, p_max + 1):
+	error = abs(interpolate(pressure) - altitude(pressure))
+	if error > max_error:
+		max_error = error
+		max_error_pressure = pressure
+
+print("nodes: " + str(nodes) + " (" + str(nodes * 4) + " bytes)")
+print("max error: " + "{0:.4f}".format(max_error) + " m at " + str(max_error_pressure) + " Pa")
+
+
+table_name = os.path.splitext( os.path.basename(output) )[0].upper()
+out_file = open(output, "w")
+
+# header
+out_file.write("#ifndef " + table_name + "_H\n")
+out_file.write("#define " + table_name + "_H\n")
+out_file.write("\n")
+out_file.write("// Generated by tools/altitude_table_generator.py\n")
+out_file.write("//   -o " + output + "\n")
+out_file.write("//   -n " + str(p_min) + "\n")
+out_file.write("//   -x " + str(p_max) + "\n")
+out_file.write("//   -s " + str(step_log2) + "\n")
+out_file.write("//\n")
+out_file.write("// Altitude in m (Q16.16) at pressure START + n * (1 << STEP_LOG2) Pa\n")
+out_file.write("// Max quadratic interpolation error: " + "{0:.4f}".format(max_error) + " m\n")
+out_file.write("\n")
+out_file.write("#include <stdint.h>\n")
+out_file.write("#include <avr/pgmspace.h>\n")
+out_file.write("\n")
+out_file.write("#define " + table_name + "_START      " + str(start) + "\n")
+out_file.write("#define " + table_name + "_STEP_LOG2  " + str(step_log2) + "\n")
+out_file.write("#define " + table_name + "_LEN        " + str(nodes) + "\n")
+out_file.write("\n")
+out_file.write("const PROGMEM int32_t _" + table_name.lower() + "[" + str(nodes) + "] = {\n")
+
+group = 4
+array_lines = math.ceil(nodes / group)
+
+for line in range(array_lines):
+	out_line = "	"
+	for value in table[line * group : (line + 1) * group]:
+		out_line += str(value) + ", "
+
+	out_file.write(out_line + "\n")
+
+out_file.write("};\n")
+out_file.write("\n")
+
+out_file.write("#endif // " + table_name + "_H\n")
+out_file.close()
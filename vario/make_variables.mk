@@ -31,7 +31,7 @@ ASFLAGS    = -c -Os -mmcu=$(DEVICE) -DF_CPU=$(F_CPU)UL -x assembler-with-cpp -Wa
 CFLAGS     += -mmcu=$(DEVICE) -DF_CPU=$(F_CPU) -DBAUD=$(UART_BAUD) -DREDUCE_BINARY_SIZE
 CXXFLAGS   += -mmcu=$(DEVICE) -DF_CPU=$(F_CPU) -DBAUD=$(UART_BAUD) -DREDUCE_BINARY_SIZE
 
-LDFLAGS    = -Os -mmcu=$(DEVICE) $(OPT_FLAGS) -Wl,--relax,--gc-sections,-u,vfprintf -lprintf_flt -lm
+LDFLAGS    = -Os -mmcu=$(DEVICE) $(OPT_FLAGS) -Wl,--relax,--gc-sections,-u,vfprintf
 
 #AVRDUDE = avrdude -F -v -p $(DEVICE) -c $(PROGRAMMER) -P $(PORT) -b $(FLASH_BAUD) -D 
 AVRDUDE    = avrdude -v -p $(DEVICE) -c $(PROGRAMMER) -P $(PORT) -b $(FLASH_BAUD) -D
@@ -43,4 +43,14 @@ ifeq ($(DEBUG), 1)
 	CFLAGS += -DDEBUG
 	CXXFLAGS += -DDEBUG
 	ASFLAGS += -DDEBUG
+endif
+
+# FIXED_POINT: integer measurement/filter/audio/display chain, no float printf and libm,
+# vertical speed from the mean filter (VARIO_FILTER_MEAN), the only one in fixed point
+FIXED_POINT ?= 0
+ifeq ($(FIXED_POINT), 1)
+	CFLAGS += -DVARIO_FIXED_POINT -DBME280_INT_COMPENSATION -DVARIO_FILTER=0
+	CXXFLAGS += -DVARIO_FIXED_POINT -DBME280_INT_COMPENSATION -DVARIO_FILTER=0
+else
+	LDFLAGS += -lprintf_flt -lm
 endif
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "bme280.h"
+#include "bme280_altitude_table.h"
 
 #include <util/delay.h>
 #include <math.h> 
@@ -6,37 +7,87 @@
 #include "../../utils/time_clock/time_clock.h"
 
 
-#ifdef DEBUG
+#if defined(DEBUG) || defined(BME280_BENCHMARK)
 #include <stdio.h>
 #endif
 
 #define BME280_CONCAT_BYTES(msb, lsb)	 (((uint16_t)msb << 8) | (uint16_t)lsb)
 
 
-uint32_t BME280ACQdelay(const BME280Settings &settings)
+// Oversampling count indexed by osrs_x setting
+const PROGMEM uint8_t _bme280_oversampling[8] = { 0, 1, 2, 4, 8, 16, 16, 16 };
+
+// Measurement time in us (datasheet 9.1), terms of disabled measurements are omitted
+static uint32_t BME280measurementTime(const BME280Settings &settings, uint16_t offset, uint16_t duration, uint16_t pres_hum_offset)
 {
-	uint8_t osr_sett_to_act_osr[] = { 0, 1, 2, 4, 8, 16, 16, 16 };
+	uint8_t osrs_t = pgm_read_byte( &(_bme280_oversampling[settings.ctrl_meas.osrs_t]) );
+	uint8_t osrs_p = pgm_read_byte( &(_bme280_oversampling[settings.ctrl_meas.osrs_p]) );
+	uint8_t osrs_h = pgm_read_byte( &(_bme280_oversampling[settings.ctrl_hum.osrs_h]) );
 
-	return (uint32_t)( 
-		(
-			BME280_MEAS_OFFSET + (BME280_MEAS_DURATION * (uint32_t)osr_sett_to_act_osr[settings.ctrl_meas.osrs_t]) +
-			BME280_PRES_HUM_MEAS_OFFSET + (BME280_MEAS_DURATION * (uint32_t)osr_sett_to_act_osr[settings.ctrl_meas.osrs_p]) +
-			BME280_PRES_HUM_MEAS_OFFSET + (BME280_MEAS_DURATION * (uint32_t)osr_sett_to_act_osr[settings.ctrl_hum.osrs_h])
-		) / BME280_MEAS_SCALING_FACTOR
-	);
+	uint32_t measurement = offset + (uint32_t)duration * osrs_t;
+	if(osrs_p) measurement += pres_hum_offset + (uint32_t)duration * osrs_p;
+	if(osrs_h) measurement += pres_hum_offset + (uint32_t)duration * osrs_h;
+
+	return measurement;
+}
+
+uint32_t BME280ACQdelay(const BME280Settings &settings)
+{
+	return BME280measurementTime(settings, BME280_MEAS_OFFSET, BME280_MEAS_DURATION, BME280_PRES_HUM_MEAS_OFFSET) / BME280_MEAS_SCALING_FACTOR;
 }
 
 uint32_t BME280ACQmaxDelay(const BME280Settings &settings)
 {
-	uint8_t osr_sett_to_act_osr[] = { 0, 1, 2, 4, 8, 16, 16, 16 };
+	return BME280measurementTime(settings, BME280_MEAS_MAX_OFFSET, BME280_MEAS_MAX_DURATION, BME280_PRES_HUM_MEAS_MAX_OFFSET) / BME280_MEAS_SCALING_FACTOR;
+}
 
-	return (uint32_t)( 
-		(
-			BME280_MEAS_MAX_OFFSET + (BME280_MEAS_MAX_DURATION * (uint32_t)osr_sett_to_act_osr[settings.ctrl_meas.osrs_t]) +
-			BME280_PRES_HUM_MEAS_MAX_OFFSET + (BME280_MEAS_MAX_DURATION * (uint32_t)osr_sett_to_act_osr[settings.ctrl_meas.osrs_p]) +
-			BME280_PRES_HUM_MEAS_MAX_OFFSET + (BME280_MEAS_MAX_DURATION * (uint32_t)osr_sett_to_act_osr[settings.ctrl_hum.osrs_h])
-		) / BME280_MEAS_SCALING_FACTOR
-	);
+// Standby time in us indexed by t_sb
+const PROGMEM uint32_t _bme280_standby_us[8] = {
+	500, 62500, 125000, 250000, 500000, 1000000, 10000, 20000
+};
+
+// Samples to reach 75 % of step response indexed by filter coefficient (datasheet 3.4.4)
+const PROGMEM uint8_t _bme280_filter_step_samples[5] = { 1, 2, 5, 11, 22 };
+
+// Pressure RMS noise in Pa * 10 indexed by [filter][osrs_p - 1] (datasheet 3.4.4)
+const PROGMEM uint8_t _bme280_pressure_noise[5][5] = {
+	{ 33, 26, 21, 16, 13 },
+	{ 19, 15, 12, 10, 8 },
+	{ 12, 10, 8, 6, 5 },
+	{ 9, 6, 5, 4, 4 },
+	{ 4, 4, 3, 2, 2 }
+};
+
+uint32_t BME280samplePeriod(const BME280Settings &settings)
+{
+	uint32_t measurement = BME280measurementTime(settings, BME280_MEAS_OFFSET, BME280_MEAS_DURATION, BME280_PRES_HUM_MEAS_OFFSET);
+
+	return measurement + pgm_read_dword( &(_bme280_standby_us[settings.config.t_sb]) );
+}
+
+uint32_t BME280outputDataRate(const BME280Settings &settings)
+{
+	return 1000000000UL / BME280samplePeriod(settings);
+}
+
+uint32_t BME280filterLatency(const BME280Settings &settings)
+{
+	uint8_t filter = settings.config.filter;
+	if(filter > BME280driver::FILTER_X16) filter = BME280driver::FILTER_X16;
+
+	return (uint32_t)pgm_read_byte( &(_bme280_filter_step_samples[filter]) ) * BME280samplePeriod(settings);
+}
+
+uint16_t BME280altitudeNoise(const BME280Settings &settings)
+{
+	uint8_t filter = settings.config.filter;
+	uint8_t osrs_p = settings.ctrl_meas.osrs_p;
+
+	if(osrs_p == BME280driver::SAMPLING_NONE) return 0;
+	if(osrs_p > BME280driver::SAMPLING_X16) osrs_p = BME280driver::SAMPLING_X16;
+	if(filter > BME280driver::FILTER_X16) filter = BME280driver::FILTER_X16;
+
+	return ( (uint16_t)pgm_read_byte( &(_bme280_pressure_noise[filter][osrs_p - 1]) ) * BME280_ALTITUDE_PER_PA + 50) / 100;
 }
 
 int8_t BME280driver::read(uint8_t reg_addr, uint8_t *data, uint32_t len)
@@ -47,9 +98,8 @@ int8_t BME280driver::read(uint8_t reg_addr, uint8_t *data, uint32_t len)
 		// Set reg_addr
 		if (i2c_write(reg_addr) == I2C_OK)
 		{
-			i2c_stop();
-			// Start i2c read
-			if (i2c_start(dev_addr << 1 | I2C_READ) == I2C_OK)
+			// Repeated start i2c read, bus is not released between reg_addr and data
+			if (i2c_rep_start(dev_addr << 1 | I2C_READ) == I2C_OK)
 			{
 				// Read data
 				for(uint32_t i = 0; i < len; i++) 
@@ -64,6 +114,7 @@ int8_t BME280driver::read(uint8_t reg_addr, uint8_t *data, uint32_t len)
 				// Data read success
 				return BME280_OK;
 			}
+			i2c_stop();
 			// i2c start read fail
 			return BME280_ERR_CONN_FAIL;
 		}
@@ -71,10 +122,40 @@ int8_t BME280driver::read(uint8_t reg_addr, uint8_t *data, uint32_t len)
 		// reg_addr setting fail
 		return BME280_ERR_WRITE_FAIL;
 	}
+	i2c_stop();
 	// i2c start write fail
 	return BME280_ERR_CONN_FAIL;
 }
 
+#ifdef BME280_BENCHMARK
+int8_t BME280driver::readStopStart(uint8_t reg_addr, uint8_t *data, uint32_t len)
+{
+	if (i2c_start(dev_addr << 1 | I2C_WRITE) == I2C_OK)
+	{
+		if (i2c_write(reg_addr) == I2C_OK)
+		{
+			i2c_stop();
+			if (i2c_start(dev_addr << 1 | I2C_READ) == I2C_OK)
+			{
+				for(uint32_t i = 0; i < len; i++) 
+				{
+					if(i != (len - 1) ) data[i] = i2c_readAck();
+					else data[i] = i2c_readNak();
+				}
+				i2c_stop();
+				return BME280_OK;
+			}
+			i2c_stop();
+			return BME280_ERR_CONN_FAIL;
+		}
+		i2c_stop();
+		return BME280_ERR_WRITE_FAIL;
+	}
+	i2c_stop();
+	return BME280_ERR_CONN_FAIL;
+}
+#endif
+
 int8_t BME280driver::write(uint8_t reg_addr, uint8_t *data, uint32_t len)
 {
 	// Start i2c write
@@ -107,6 +188,7 @@ int8_t BME280driver::write(uint8_t reg_addr, uint8_t *data, uint32_t len)
 		// Data write success
 		return BME280_OK;
 	}
+	i2c_stop();
 	// i2c start write fail
 	return BME280_ERR_CONN_FAIL;
 }
@@ -119,9 +201,8 @@ int8_t BME280driver::read(uint8_t reg_addr, uint8_t *data)
 		// Set reg_addr
 		if (i2c_write(reg_addr) == I2C_OK)
 		{
-			i2c_stop();
-			// Start i2c read
-			if (i2c_start(dev_addr << 1 | I2C_READ) == I2C_OK)
+			// Repeated start i2c read, bus is not released between reg_addr and data
+			if (i2c_rep_start(dev_addr << 1 | I2C_READ) == I2C_OK)
 			{
 				// Read data
 				*data = i2c_readNak();
@@ -132,6 +213,7 @@ int8_t BME280driver::read(uint8_t reg_addr, uint8_t *data)
 				// Data read success
 				return BME280_OK;
 			}
+			i2c_stop();
 			// i2c start read fail
 			return BME280_ERR_CONN_FAIL;
 		}
@@ -139,6 +221,7 @@ int8_t BME280driver::read(uint8_t reg_addr, uint8_t *data)
 		// reg_addr setting fail
 		return BME280_ERR_WRITE_FAIL;
 	}
+	i2c_stop();
 	// i2c start write fail
 	return BME280_ERR_CONN_FAIL;
 }
@@ -169,6 +252,7 @@ int8_t BME280driver::write(uint8_t reg_addr, uint8_t data)
 		// reg_addr setting fail
 		return BME280_ERR_WRITE_FAIL;
 	}
+	i2c_stop();
 	// i2c start write fail
 	return BME280_ERR_CONN_FAIL;
 }
@@ -477,13 +561,111 @@ int8_t BME280driver::readData(uint32_t *pressure, uint32_t *temperature, uint32_
 	return res;
 }
 
+void BME280driver::parseStatusData(const uint8_t *reg_data, uint8_t data_len, uint32_t *pressure, uint32_t *temperature, uint32_t *humidity, bool *new_sample)
+{
+	BME280_reg_status status { .raw = reg_data[0] };
+	const uint8_t *data = reg_data + BME280_STATUS_DATA_OFFSET;
+
+	*new_sample = false;
+
+	// Conversion ended since last read or data registers were updated,
+	// channels not read last time are not compared
+	if(last_measuring && !status.measuring) *new_sample = true;
+	for(uint8_t i = 0; i < data_len; i++)
+	{
+		if(data[i] != last_data[i])
+		{
+			if(i < last_data_len) *new_sample = true;
+			last_data[i] = data[i];
+		}
+	}
+	last_measuring = status.measuring;
+	last_data_len = data_len;
+
+	*pressure = ( (uint32_t)data[0] << 12) + ( (uint32_t)data[1] << 4) + ( (uint32_t)data[2] >> 4);
+
+	if(temperature != nullptr)
+	{
+		*temperature = ( (uint32_t)data[3] << 12) + ( (uint32_t)data[4] << 4) + ( (uint32_t)data[5] >> 4);
+	}
+
+	if(humidity != nullptr)
+	{
+		*humidity = ( (uint32_t)data[6] << 8) + ( (uint32_t)data[7]);
+	}
+}
+
+int8_t BME280driver::readStatusData(uint32_t *pressure, uint32_t *temperature, uint32_t *humidity, bool *new_sample)
+{
+	uint8_t reg_data[BME280_STATUS_DATA_LEN] = { 0 };
+
+	// Burst starts at status register, read only up to last requested channel
+	uint8_t data_len = BME280_P_DATA_LEN;
+	if(temperature != nullptr) data_len = BME280_P_DATA_LEN + BME280_T_DATA_LEN;
+	if(humidity != nullptr) data_len = BME280_P_T_H_DATA_LEN;
+
+	// Read status and data in one transaction, data registers are shadowed during burst
+	int8_t res = read(BME280_REG_STATUS, reg_data, BME280_STATUS_DATA_OFFSET + data_len);
+
+	*new_sample = false;
+
+	if (res == BME280_OK) parseStatusData(reg_data, data_len, pressure, temperature, humidity, new_sample);
+
+	return res;
+}
+
+static const uint8_t bme280_status_reg = BME280_REG_STATUS;
+
+int8_t BME280driver::submitStatusData(i2c_transaction *transaction, uint8_t *reg_data, void (*callback)(i2c_transaction *t))
+{
+	transaction->addr = dev_addr;
+	transaction->tx_data = &bme280_status_reg;
+	transaction->tx_len = 1;
+	transaction->rx_data = reg_data;
+	transaction->rx_len = BME280_STATUS_DATA_LEN;
+	transaction->callback = callback;
+
+	if(i2c_submit(transaction) != I2C_OK) return BME280_ERR_CONN_FAIL;
+	return BME280_OK;
+}
+
+#ifdef BME280_BENCHMARK
+void BME280driver::benchmarkRead()
+{
+	uint8_t reg_data[BME280_STATUS_DATA_LEN];
+	const uint8_t lengths[2] = { 1, BME280_STATUS_DATA_LEN };
+
+	for(uint8_t l = 0; l < 2; l++)
+	{
+		uint32_t time[2];
+		for(uint8_t method = 0; method < 2; method++)
+		{
+			uint32_t start = timer_get_us();
+			for(uint8_t r = 0; r < BME280_BENCHMARK_RUNS; r++)
+			{
+				if(method) read(BME280_REG_STATUS, reg_data, lengths[l]);
+				else readStopStart(BME280_REG_STATUS, reg_data, lengths[l]);
+			}
+			time[method] = timer_get_us() - start;
+		}
+
+		printf(
+			"read %u B: stop+start %lu us, repeated start %lu us\n",
+			lengths[l],
+			time[0] / BME280_BENCHMARK_RUNS,
+			time[1] / BME280_BENCHMARK_RUNS
+		);
+	}
+}
+#endif
+
 BME280::BME280(uint8_t dev_addr) : BME280driver(dev_addr)
 {
 	// Initial temperature reading to calculate t_fine, t_fine_adjust
 
 	setTemperatureSampling(BME280::SAMPLING_X1);
-	float temperature;
-	singleMeasure(nullptr, &temperature);
+	int32_t temperature;
+	singleMeasure(nullptr, &temperature, nullptr);
 }
 
 void BME280::setFilter(const Filter filter)
@@ -557,7 +739,7 @@ int8_t BME280::applySettings()
 	return res;
 }
 
-float BME280::compensateTemperature(uint32_t &uncomp_temperature)
+int32_t BME280::compensateTemperatureInt(uint32_t &uncomp_temperature)
 {
 	int32_t var1, var2;
 
@@ -568,12 +750,44 @@ float BME280::compensateTemperature(uint32_t &uncomp_temperature)
 
 	t_fine = var1 + var2 + t_fine_adjust;
 
-	return (float)((t_fine * 5 + 128) / 256) / 100;
+	return (t_fine * 5 + 128) / 256;
 }
 
-float BME280::compensatePressure(uint32_t &uncomp_pressure)
+#ifdef BME280_PRESSURE_32BIT
+uint32_t BME280::compensatePressureInt(uint32_t &uncomp_pressure)
+{
+	int32_t var1, var2, var3, var4;
+	uint32_t var5, pressure;
+
+	var1 = (((int32_t)t_fine) / 2) - (int32_t)64000;
+	var2 = (((var1 / 4) * (var1 / 4)) / 2048) * ((int32_t)calib_data.dig_p6);
+	var2 = var2 + ((var1 * ((int32_t)calib_data.dig_p5)) * 2);
+	var2 = (var2 / 4) + (((int32_t)calib_data.dig_p4) * 65536);
+	var3 = (calib_data.dig_p3 * (((var1 / 4) * (var1 / 4)) / 8192)) / 8;
+	var4 = (((int32_t)calib_data.dig_p2) * var1) / 2;
+	var1 = (var3 + var4) / 262144;
+	var1 = (((32768 + var1)) * ((int32_t)calib_data.dig_p1)) / 32768;
+
+	if (var1 == 0) {
+		return 0; // avoid exception caused by division by zero
+	}
+
+	var5 = (uint32_t)((uint32_t)1048576) - uncomp_pressure;
+	pressure = ((uint32_t)(var5 - (uint32_t)(var2 / 4096))) * 3125;
+	if (pressure < 0x80000000) pressure = (pressure << 1) / ((uint32_t)var1);
+	else pressure = (pressure / (uint32_t)var1) * 2;
+
+	var1 = (((int32_t)calib_data.dig_p9) * ((int32_t)(((pressure / 8) * (pressure / 8)) / 8192))) / 4096;
+	var2 = (((int32_t)(pressure / 4)) * ((int32_t)calib_data.dig_p8)) / 8192;
+	pressure = (uint32_t)((int32_t)pressure + ((var1 + var2 + calib_data.dig_p7) / 16));
+
+	// Pa to Q24.8
+	return pressure * 256;
+}
+#else
+void BME280::updatePressureCache()
 {
-	int64_t var1, var2, var3, var4;
+	int64_t var1, var2, var3;
 
 	var1 = ((int64_t)t_fine) - 128000;
 	var2 = var1 * var1 * (int64_t)calib_data.dig_p6;
@@ -584,21 +798,64 @@ float BME280::compensatePressure(uint32_t &uncomp_pressure)
 	var3 = ((int64_t)1) * 140737488355328;
 	var1 = (var3 + var1) * ((int64_t)calib_data.dig_p1) / 8589934592;
 
-	if (var1 == 0) {
-		return NAN; // avoid exception caused by division by zero
+	press_cache_offset = var2;
+	press_cache_divisor = var1;
+	press_cache_t_fine = t_fine;
+	press_cache_valid = true;
+}
+
+uint32_t BME280::compensatePressureInt(uint32_t &uncomp_pressure)
+{
+	int64_t var1, var2, var4;
+
+	if( !press_cache_valid || (press_cache_t_fine != t_fine) ) updatePressureCache();
+
+	if (press_cache_divisor == 0) {
+		return 0; // avoid exception caused by division by zero
 	}
 
 	var4 = 1048576 - uncomp_pressure;
-	var4 = (((var4 * 2147483648) - var2) * 3125) / var1;
+	var4 = (((var4 * 2147483648) - press_cache_offset) * 3125) / press_cache_divisor;
 	var1 = (((int64_t)calib_data.dig_p9) * (var4 / 8192) * (var4 / 8192)) /
 		33554432;
 	var2 = (((int64_t)calib_data.dig_p8) * var4) / 524288;
 	var4 = ((var4 + var1 + var2) / 256) + (((int64_t)calib_data.dig_p7) * 16);
 
-	return (float) (var4 / 256.0);
+	return (uint32_t)var4;
 }
 
-float BME280::compensateHumidity(uint32_t &uncomp_humidity)
+#ifdef BME280_BENCHMARK
+void BME280::benchmarkCompensation()
+{
+	// Datasheet example raw pressure, t_fine of last temperature reading
+	uint32_t uncomp_pressure = 415148;
+	uint32_t pressure[2];
+	uint32_t time[2];
+
+	for(uint8_t method = 0; method < 2; method++)
+	{
+		uint32_t start = timer_get_us();
+		for(uint8_t r = 0; r < BME280_BENCHMARK_RUNS; r++)
+		{
+			// Uncached: every sample pays the t_fine terms, as before the cache
+			if(!method) press_cache_valid = false;
+			pressure[method] = compensatePressureInt(uncomp_pressure);
+		}
+		time[method] = timer_get_us() - start;
+	}
+
+	printf(
+		"compensatePressureInt: uncached %lu cycles, cached %lu cycles (%lu, %lu Pa/256)\n",
+		time[0] * (F_CPU / 1000000) / BME280_BENCHMARK_RUNS,
+		time[1] * (F_CPU / 1000000) / BME280_BENCHMARK_RUNS,
+		pressure[0],
+		pressure[1]
+	);
+}
+#endif
+#endif
+
+uint32_t BME280::compensateHumidityInt(uint32_t &uncomp_humidity)
 {
 	int32_t var1, var2, var3, var4, var5;
 
@@ -617,7 +874,25 @@ float BME280::compensateHumidity(uint32_t &uncomp_humidity)
 	var5 = (var5 < 0 ? 0 : var5);
 	var5 = (var5 > 419430400 ? 419430400 : var5);
 
-	return (float)( (uint32_t)(var5 / 4096) ) / 1024.0;
+	return (uint32_t)(var5 / 4096);
+}
+
+#ifndef BME280_INT_COMPENSATION
+float BME280::compensateTemperature(uint32_t &uncomp_temperature)
+{
+	return (float)compensateTemperatureInt(uncomp_temperature) / 100;
+}
+
+float BME280::compensatePressure(uint32_t &uncomp_pressure)
+{
+	uint32_t pressure = compensatePressureInt(uncomp_pressure);
+	if (pressure == 0) return NAN;
+	return (float) (pressure / 256.0);
+}
+
+float BME280::compensateHumidity(uint32_t &uncomp_humidity)
+{
+	return (float)compensateHumidityInt(uncomp_humidity) / 1024.0;
 }
 
 int8_t BME280::singleMeasure(float *pressure, float *temperature, float *humidity)
@@ -641,12 +916,39 @@ int8_t BME280::singleMeasure(float *pressure, float *temperature, float *humidit
 
 	return res;
 }
+#endif
+
+int8_t BME280::singleMeasure(uint32_t *pressure, int32_t *temperature, uint32_t *humidity)
+{
+	uint32_t uncomp_pressure=0, uncomp_temperature=0, uncomp_humidity=0;
+	int8_t res = BME280_OK;
+
+	if(changed_settings.raw) res = applySettings();
+	
+	if(res == BME280_OK) res = runForcedACQ();
+
+	if(res == BME280_OK) res = BME280driver::readData(
+		(settings.ctrl_meas.osrs_p ? &uncomp_pressure : nullptr),
+		(settings.ctrl_meas.osrs_t ? &uncomp_temperature : nullptr),
+		(settings.ctrl_hum.osrs_h ? &uncomp_humidity : nullptr)
+	);
+
+	if( (temperature != nullptr) && (settings.ctrl_meas.osrs_t) ) *temperature = compensateTemperatureInt(uncomp_temperature);
+	if( (pressure != nullptr) && (settings.ctrl_meas.osrs_p) ) *pressure = compensatePressureInt(uncomp_pressure);
+	if( (humidity != nullptr) && (settings.ctrl_hum.osrs_h) ) *humidity = compensateHumidityInt(uncomp_humidity);
+
+	return res;
+}
 
 int8_t BME280::startNormalACQ()
 {
 	int8_t res = BME280_OK;
 	if(changed_settings.raw) res = applySettings();
 	if(res == BME280_OK) res = writeMode(MODE_NORMAL);
+
+	// First sample refreshes all channels
+	temperature_countdown = 0;
+	humidity_countdown = 0;
 	return res;
 }
 
@@ -655,6 +957,7 @@ int8_t BME280::stopNormalACQ()
 	return writeMode(MODE_SLEEP);
 }
 
+#ifndef BME280_INT_COMPENSATION
 int8_t BME280::readData(float *pressure, float *temperature, float *humidity)
 {
 	uint32_t uncomp_pressure=0, uncomp_temperature=0, uncomp_humidity=0;
@@ -671,6 +974,120 @@ int8_t BME280::readData(float *pressure, float *temperature, float *humidity)
 	return res;
 }
 
+static void BME280intToFloat(uint32_t pressure_int, int32_t temperature_int, uint32_t humidity_int, float *pressure, float *temperature, float *humidity)
+{
+	if(temperature != nullptr) *temperature = (float)temperature_int / 100;
+	if(pressure != nullptr) *pressure = (pressure_int == 0) ? NAN : (float) (pressure_int / 256.0);
+	if(humidity != nullptr) *humidity = (float)humidity_int / 1024.0;
+}
+
+int8_t BME280::readData(float *pressure, float *temperature, float *humidity, bool *new_sample)
+{
+	uint32_t pressure_int = 0, humidity_int = 0;
+	int32_t temperature_int = 0;
+	int8_t res = readData(&pressure_int, &temperature_int, &humidity_int, new_sample);
+
+	if( (res != BME280_OK) || !(*new_sample) ) return res;
+
+	BME280intToFloat(pressure_int, temperature_int, humidity_int, pressure, temperature, humidity);
+	return res;
+}
+
+int8_t BME280::decodeData(const uint8_t *reg_data, float *pressure, float *temperature, float *humidity, bool *new_sample)
+{
+	uint32_t pressure_int = 0, humidity_int = 0;
+	int32_t temperature_int = 0;
+	int8_t res = decodeData(reg_data, &pressure_int, &temperature_int, &humidity_int, new_sample);
+
+	if( (res != BME280_OK) || !(*new_sample) ) return res;
+
+	BME280intToFloat(pressure_int, temperature_int, humidity_int, pressure, temperature, humidity);
+	return res;
+}
+#endif
+
+void BME280::compensateSample(uint32_t &uncomp_pressure, uint32_t &uncomp_temperature, uint32_t &uncomp_humidity, bool read_temperature, bool read_humidity)
+{
+	if(read_temperature)
+	{
+		last_temperature = compensateTemperatureInt(uncomp_temperature);
+		temperature_countdown = temperature_decimation;
+	}
+	if(settings.ctrl_meas.osrs_p) last_pressure = compensatePressureInt(uncomp_pressure);
+	if(read_humidity)
+	{
+		last_humidity = compensateHumidityInt(uncomp_humidity);
+		humidity_countdown = humidity_decimation;
+	}
+	if(temperature_countdown) temperature_countdown--;
+	if(humidity_countdown) humidity_countdown--;
+}
+
+int8_t BME280::readData(uint32_t *pressure, int32_t *temperature, uint32_t *humidity, bool *new_sample)
+{
+	uint32_t uncomp_pressure=0, uncomp_temperature=0, uncomp_humidity=0;
+
+	// Decimated channels are read and compensated only every N-th sample
+	bool read_temperature = settings.ctrl_meas.osrs_t && (temperature_countdown == 0);
+	bool read_humidity = settings.ctrl_hum.osrs_h && (humidity_countdown == 0);
+
+	int8_t res = readStatusData(
+		&uncomp_pressure,
+		( (read_temperature || read_humidity) ? &uncomp_temperature : nullptr),
+		(read_humidity ? &uncomp_humidity : nullptr),
+		new_sample
+	);
+
+	// Skip compensation of already seen sample
+	if( (res != BME280_OK) || !(*new_sample) ) return res;
+
+	compensateSample(uncomp_pressure, uncomp_temperature, uncomp_humidity, read_temperature, read_humidity);
+
+	if(temperature != nullptr) *temperature = last_temperature;
+	if(pressure != nullptr) *pressure = last_pressure;
+	if(humidity != nullptr) *humidity = last_humidity;
+
+	return res;
+}
+
+int8_t BME280::decodeData(const uint8_t *reg_data, uint32_t *pressure, int32_t *temperature, uint32_t *humidity, bool *new_sample)
+{
+	uint32_t uncomp_pressure=0, uncomp_temperature=0, uncomp_humidity=0;
+
+	parseStatusData(reg_data, BME280_P_T_H_DATA_LEN, &uncomp_pressure, &uncomp_temperature, &uncomp_humidity, new_sample);
+
+	// Skip compensation of already seen sample
+	if(!(*new_sample)) return BME280_OK;
+
+	// All channels are in the burst, decimation only saves compensation
+	compensateSample(
+		uncomp_pressure,
+		uncomp_temperature,
+		uncomp_humidity,
+		settings.ctrl_meas.osrs_t && (temperature_countdown == 0),
+		settings.ctrl_hum.osrs_h && (humidity_countdown == 0)
+	);
+
+	if(temperature != nullptr) *temperature = last_temperature;
+	if(pressure != nullptr) *pressure = last_pressure;
+	if(humidity != nullptr) *humidity = last_humidity;
+
+	return BME280_OK;
+}
+
+void BME280::setTemperatureDecimation(const uint8_t decimation)
+{
+	temperature_decimation = decimation ? decimation : 1;
+	temperature_countdown = 0;
+}
+
+void BME280::setHumidityDecimation(const uint8_t decimation)
+{
+	humidity_decimation = decimation ? decimation : 1;
+	humidity_countdown = 0;
+}
+
+#ifndef VARIO_FIXED_POINT
 float BME280calcAltitude(float pressure) {
   return 44330.0 * (1.0 - pow(pressure / BME280_ALT_SEA_LEVEL_PRESSURE, BME280_ALT_HYPSOMETRIC_F_POW));
 }
@@ -678,3 +1095,92 @@ float BME280calcAltitude(float pressure) {
 float BME280calcAltitude(float pressure, float temperature) {
   return BME280_ALT_MULT_CONST * (BME280_ALT_T_0_K + temperature) * (1.0 - pow(pressure / BME280_ALT_SEA_LEVEL_PRESSURE, BME280_ALT_HYPSOMETRIC_F_POW));
 }
+
+float BME280calcAltitudeFast(float pressure) {
+	float x = (pressure - BME280_ALTITUDE_TABLE_START) * (1.0 / (1 << BME280_ALTITUDE_TABLE_STEP_LOG2));
+
+	// Out of range pressures are extrapolated from first/last nodes
+	int16_t i = (x > 0) ? (int16_t)x : 0;
+	if(i > (BME280_ALTITUDE_TABLE_LEN - 3)) i = BME280_ALTITUDE_TABLE_LEN - 3;
+	float u = x - i;
+
+	int32_t h0 = pgm_read_dword( &(_bme280_altitude_table[i]) );
+	int32_t h1 = pgm_read_dword( &(_bme280_altitude_table[i + 1]) );
+	int32_t h2 = pgm_read_dword( &(_bme280_altitude_table[i + 2]) );
+
+	// Newton forward differences
+	int32_t d1 = h1 - h0;
+	int32_t d2 = h2 - 2 * h1 + h0;
+
+	return (h0 + u * (d1 + (u - 1) * d2 * 0.5)) / 65536.0;
+}
+#endif
+
+int32_t BME280calcAltitudeFixed(uint32_t pressure) {
+	// Node index and position between nodes in Q(STEP_LOG2 + 8)
+	int32_t x = (int32_t)pressure - ( (int32_t)BME280_ALTITUDE_TABLE_START << 8);
+
+	// Out of range pressures are extrapolated from first/last nodes
+	int16_t i = (x > 0) ? (int16_t)(x >> (BME280_ALTITUDE_TABLE_STEP_LOG2 + 8)) : 0;
+	if(i > (BME280_ALTITUDE_TABLE_LEN - 3)) i = BME280_ALTITUDE_TABLE_LEN - 3;
+
+	// u in Q16
+	int32_t u = x - ( (int32_t)i << (BME280_ALTITUDE_TABLE_STEP_LOG2 + 8) );
+#if (BME280_ALTITUDE_TABLE_STEP_LOG2 + 8) >= 16
+	u >>= (BME280_ALTITUDE_TABLE_STEP_LOG2 + 8 - 16);
+#else
+	u <<= (16 - BME280_ALTITUDE_TABLE_STEP_LOG2 - 8);
+#endif
+
+	int32_t h0 = pgm_read_dword( &(_bme280_altitude_table[i]) );
+	int32_t h1 = pgm_read_dword( &(_bme280_altitude_table[i + 1]) );
+	int32_t h2 = pgm_read_dword( &(_bme280_altitude_table[i + 2]) );
+
+	// Newton forward differences
+	int32_t d1 = h1 - h0;
+	int32_t d2 = h2 - 2 * h1 + h0;
+
+	int32_t slope = d1 + (int32_t)( ( (int64_t)(u - 65536) * d2) >> 17);
+	return h0 + (int32_t)( ( (int64_t)u * slope) >> 16);
+}
+
+#if defined(BME280_BENCHMARK) && !defined(VARIO_FIXED_POINT)
+void BME280benchmarkAltitude()
+{
+	// Pa, sweep of BME280_BENCHMARK_RUNS pressures
+	const float p_min = 30000;
+	const float p_step = (110000 - p_min) / BME280_BENCHMARK_RUNS;
+	volatile float sink = 0;
+	float max_error = 0;
+	uint32_t time[3];
+
+	for(uint8_t method = 0; method < 3; method++)
+	{
+		uint32_t start = timer_get_us();
+		for(uint8_t r = 0; r < BME280_BENCHMARK_RUNS; r++)
+		{
+			float pressure = p_min + r * p_step;
+			if(method == 0) sink = BME280calcAltitude(pressure);
+			else if(method == 1) sink = BME280calcAltitudeFast(pressure);
+			else sink = BME280calcAltitudeFixed( (uint32_t)(pressure * 256) );
+		}
+		time[method] = timer_get_us() - start;
+	}
+
+	for(uint8_t r = 0; r < BME280_BENCHMARK_RUNS; r++)
+	{
+		float pressure = p_min + r * p_step;
+		float error = fabs(BME280calcAltitudeFast(pressure) - BME280calcAltitude(pressure) );
+		if(error > max_error) max_error = error;
+	}
+	(void)sink;
+
+	printf(
+		"altitude: pow %lu cycles, table %lu cycles, fixed %lu cycles, max diff %u cm\n",
+		time[0] * (F_CPU / 1000000) / BME280_BENCHMARK_RUNS,
+		time[1] * (F_CPU / 1000000) / BME280_BENCHMARK_RUNS,
+		time[2] * (F_CPU / 1000000) / BME280_BENCHMARK_RUNS,
+		(uint16_t)(max_error * 100 + 0.5)
+	);
+}
+#endif
@@ -45,11 +45,21 @@
 
 #include <stdint.h>
 
+#include "../i2cmaster/i2cmaster.h"
+
 #define BME280_I2C_ADDR                    0x76
 #define BME280_I2C_ADDR_SEC                0x77
 
 //#define BME280_ACQ_DELAY_ENABLE
 
+// Integer only compensation, float API is not compiled
+//#define BME280_INT_COMPENSATION
+// Bosch 32-bit pressure formula (1 Pa resolution) instead of 64-bit one
+//#define BME280_PRESSURE_32BIT
+
+// Uncomment to build BME280 benchmarks, results are printed to UART
+//#define BME280_BENCHMARK
+
 #define BME280_ALT_SEA_LEVEL_PRESSURE      101325.0 // Pa
 #define BME280_ALT_HYPSOMETRIC_F_POW       0.190295
 #define BME280_ALT_T_0_K                   273.15
@@ -229,6 +239,9 @@ typedef union
 #define BME280_P_DATA_LEN                  3
 #define BME280_T_DATA_LEN                  3
 #define BME280_H_DATA_LEN                  2
+// BME280_REG_STATUS .. last data register (0xF3..0xFE)
+#define BME280_STATUS_DATA_LEN             12
+#define BME280_STATUS_DATA_OFFSET          (BME280_REG_DATA - BME280_REG_STATUS)
 
 #define BME280_MEAS_OFFSET                 1000
 #define BME280_MEAS_DURATION               2000
@@ -239,6 +252,16 @@ typedef union
 
 #define BME280_MEAS_SCALING_FACTOR         1000
 
+// Altitude change per Pa near sea level, in cm * 10
+#define BME280_ALTITUDE_PER_PA             84
+
+// Normal ACQ reads temperature/humidity every N-th new sample
+#define BME280_DEFAULT_T_DECIMATION        8
+#define BME280_DEFAULT_H_DECIMATION        32
+
+// Repetitions of each timed operation in benchmarks
+#define BME280_BENCHMARK_RUNS              100
+
 struct BME280Settings
 {
 	BME280_reg_ctrl_meas ctrl_meas {.raw = 0};
@@ -285,9 +308,20 @@ struct BME280CalibData
 
 };
 
+// Forced ACQ measurement time in ms, typical and maximum
 uint32_t BME280ACQdelay(const BME280Settings &settings);
 uint32_t BME280ACQmaxDelay(const BME280Settings &settings);
 
+// Normal ACQ figures (typical):
+//   sample period in us (measurement + standby)
+//   output data rate in mHz
+//   IIR filter latency in us, samples to reach 75 % of step response
+//   pressure noise converted to altitude, in cm RMS
+uint32_t BME280samplePeriod(const BME280Settings &settings);
+uint32_t BME280outputDataRate(const BME280Settings &settings);
+uint32_t BME280filterLatency(const BME280Settings &settings);
+uint16_t BME280altitudeNoise(const BME280Settings &settings);
+
 class BME280driver
 {
 public:
@@ -330,6 +364,11 @@ private:
 	bool device_ok;
 	uint8_t dev_addr;
 
+	// Last raw data and measuring bit, for new sample detection
+	uint8_t last_data[BME280_P_T_H_DATA_LEN] = { 0 };
+	uint8_t last_data_len = 0;
+	bool last_measuring = false;
+
 #ifdef BME280_ACQ_DELAY_ENABLE
 	uint32_t acq_delay;
 	void calcACQdelay();
@@ -337,6 +376,10 @@ private:
 	
 	int8_t read(uint8_t reg_addr, uint8_t *data, uint32_t len);
 	int8_t write(uint8_t reg_addr, uint8_t *data, uint32_t len);
+#ifdef BME280_BENCHMARK
+	// read() with STOP + START between reg_addr and data, reference for benchmarkRead()
+	int8_t readStopStart(uint8_t reg_addr, uint8_t *data, uint32_t len);
+#endif
 
 	int8_t read(uint8_t reg_addr, uint8_t *data);
 	int8_t write(uint8_t reg_addr, uint8_t data);
@@ -367,6 +410,19 @@ public:
 	int8_t runForcedACQ();
 
 	int8_t readData(uint32_t *pressure = nullptr, uint32_t *temperature = nullptr, uint32_t *humidity = nullptr);
+	// Single burst of status and data registers up to last non-null channel,
+	// pressure is always read, new_sample is set when a conversion finished since last call
+	int8_t readStatusData(uint32_t *pressure, uint32_t *temperature, uint32_t *humidity, bool *new_sample);
+	// Same as readStatusData on a burst captured by submitStatusData
+	void parseStatusData(const uint8_t *reg_data, uint8_t data_len, uint32_t *pressure, uint32_t *temperature, uint32_t *humidity, bool *new_sample);
+	// Queue interrupt driven burst of status and all data registers (BME280_STATUS_DATA_LEN bytes),
+	// transaction and reg_data must stay valid until callback
+	int8_t submitStatusData(i2c_transaction *transaction, uint8_t *reg_data, void (*callback)(i2c_transaction *t));
+
+#ifdef BME280_BENCHMARK
+	// us per blocking status and status+data read, repeated start vs STOP + START
+	void benchmarkRead();
+#endif
 };
 
 
@@ -389,6 +445,30 @@ class BME280 : public BME280driver
 
 	int32_t t_fine;
 	int32_t t_fine_adjust = 0;
+
+#ifndef BME280_PRESSURE_32BIT
+	// t_fine dependent terms of pressure compensation,
+	// recalculated only when t_fine changes
+	bool press_cache_valid = false;
+	int32_t press_cache_t_fine;
+	int64_t press_cache_offset;
+	int64_t press_cache_divisor;
+
+	void updatePressureCache();
+#endif
+
+	// Per-channel scheduler of readData, last compensated values are
+	// returned for channels not read in current sample
+	uint8_t temperature_decimation = BME280_DEFAULT_T_DECIMATION;
+	uint8_t humidity_decimation = BME280_DEFAULT_H_DECIMATION;
+	uint8_t temperature_countdown = 0;
+	uint8_t humidity_countdown = 0;
+
+	int32_t last_temperature = 0;
+	uint32_t last_pressure = 0;
+	uint32_t last_humidity = 0;
+
+	void compensateSample(uint32_t &uncomp_pressure, uint32_t &uncomp_temperature, uint32_t &uncomp_humidity, bool read_temperature, bool read_humidity);
 public:
 	BME280(uint8_t dev_addr = BME280_I2C_ADDR);
 
@@ -404,24 +484,72 @@ public:
 	void setStandbyDuration(const StandbyDuration delay);
 	StandbyDuration getStandbyDuration() const;
 
+	void setTemperatureDecimation(const uint8_t decimation);
+	uint8_t getTemperatureDecimation() const { return temperature_decimation; }
+	void setHumidityDecimation(const uint8_t decimation);
+	uint8_t getHumidityDecimation() const { return humidity_decimation; }
+
 	void setSettings(const BME280Settings &settings);
 	BME280Settings getSettings() { return settings; }
 	int8_t applySettings();
+	// Settings changed since last applySettings(), take effect on startNormalACQ()
+	bool settingsChanged() const { return changed_settings.raw; }
+
+	// Integer compensation:
+	//   temperature in 0.01 degC
+	//   pressure in Pa * 256 (Q24.8)
+	//   humidity in %RH * 1024 (Q22.10)
+	int32_t compensateTemperatureInt(uint32_t &uncomp_temperature);
+	uint32_t compensatePressureInt(uint32_t &uncomp_pressure);
+	uint32_t compensateHumidityInt(uint32_t &uncomp_humidity);
+
+#if defined(BME280_BENCHMARK) && !defined(BME280_PRESSURE_32BIT)
+	// Cycles per compensatePressureInt() with and without t_fine cache hit
+	void benchmarkCompensation();
+#endif
 
+#ifndef BME280_INT_COMPENSATION
 	float compensateTemperature(uint32_t &uncomp_temperature);
 	float compensatePressure(uint32_t &uncomp_pressure);
 	float compensateHumidity(uint32_t &uncomp_humidity);
+#endif
 
 	// Forced ACQ
+#ifndef BME280_INT_COMPENSATION
 	int8_t singleMeasure(float *pressure = nullptr, float *temperature = nullptr, float *humidity = nullptr);
+#endif
+	int8_t singleMeasure(uint32_t *pressure, int32_t *temperature, uint32_t *humidity);
 
 	// Normal ACQ
 	int8_t startNormalACQ();
 	int8_t stopNormalACQ();
+#ifndef BME280_INT_COMPENSATION
 	int8_t readData(float *pressure, float *temperature, float *humidity);
+	// Compensates only when sensor produced new sample
+	int8_t readData(float *pressure, float *temperature, float *humidity, bool *new_sample);
+	int8_t decodeData(const uint8_t *reg_data, float *pressure, float *temperature, float *humidity, bool *new_sample);
+#endif
+	int8_t readData(uint32_t *pressure, int32_t *temperature, uint32_t *humidity, bool *new_sample);
+	// Compensates burst captured by submitStatusData()
+	int8_t decodeData(const uint8_t *reg_data, uint32_t *pressure, int32_t *temperature, uint32_t *humidity, bool *new_sample);
 };
 
+// Float conversions are left out of the integer vario build, so pow()
+// and soft-float code cannot reach the image through them
+#ifndef VARIO_FIXED_POINT
 float BME280calcAltitude(float pressure);
 float BME280calcAltitude(float pressure, float temperature);
+// PROGMEM table with quadratic interpolation instead of pow(),
+// < 3 cm error within 300..1100 hPa
+float BME280calcAltitudeFast(float pressure);
+#endif
+// Same table, pressure in Pa * 256 (Q24.8), altitude in m * 65536 (Q16.16)
+int32_t BME280calcAltitudeFixed(uint32_t pressure);
+
+#if defined(BME280_BENCHMARK) && !defined(VARIO_FIXED_POINT)
+// Cycles per call of pow() based vs table altitude conversions over
+// 300..1100 hPa and max difference between them, printed to UART
+void BME280benchmarkAltitude();
+#endif
 
 #endif // BME280_H 
\ No newline at end of file
@@ -0,0 +1,44 @@
+#ifndef BME280_ALTITUDE_TABLE_H
+#define BME280_ALTITUDE_TABLE_H
+
+// Generated by tools/altitude_table_generator.py
+//   -o src/hardware/bme280/bme280_altitude_table.h
+//   -n 30000
+//   -x 110000
+//   -s 10
+//
+// Altitude in m (Q16.16) at pressure START + n * (1 << STEP_LOG2) Pa
+// Max quadratic interpolation error: 0.0237 m
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+#define BME280_ALTITUDE_TABLE_START      29696
+#define BME280_ALTITUDE_TABLE_STEP_LOG2  10
+#define BME280_ALTITUDE_TABLE_LEN        81
+
+const PROGMEM int32_t _bme280_altitude_table[81] = {
+	605110041, 590223443, 575733364, 561616950, 
+	547853325, 534423374, 521309539, 508495660, 
+	495966822, 483709232, 471710105, 459957570, 
+	448440579, 437148836, 426072726, 415203258, 
+	404532008, 394051076, 383753038, 373630911, 
+	363678118, 353888455, 344256064, 334775409, 
+	325441249, 316248618, 307192810, 298269354, 
+	289474004, 280802720, 272251658, 263817156, 
+	255495721, 247284020, 239178871, 231177233, 
+	223276197, 215472979, 207764913, 200149444, 
+	192624123, 185186599, 177834614, 170566001, 
+	163378676, 156270635, 149239949, 142284761, 
+	135403284, 128593794, 121854629, 115184186, 
+	108580919, 102043334, 95569988, 89159489, 
+	82810487, 76521681, 70291809, 64119650, 
+	58004024, 51943786, 45937828, 39985074, 
+	34084483, 28235043, 22435775, 16685727, 
+	10983974, 5329620, -278208, -5840357, 
+	-11357649, -16830885, -22260845, -27648284, 
+	-32993942, -38298533, -43562759, -48787297, 
+	-53972811, 
+};
+
+#endif // BME280_ALTITUDE_TABLE_H
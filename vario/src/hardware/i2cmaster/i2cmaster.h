@@ -102,6 +102,29 @@ extern "C" {
 
 #define I2C_OK      0
 #define I2C_ERR     1
+#define I2C_BUSY    2
+
+/** number of asynchronous transactions which may be queued at once */
+#define I2C_QUEUE_LEN  4
+
+
+/**
+ @brief Asynchronous transaction descriptor used by i2c_submit()
+
+ Write phase sends tx_len bytes from tx_data, read phase (issued with a repeated
+ start) fills rx_len bytes of rx_data. Either phase may be empty. The descriptor
+ and both buffers must stay valid until status leaves I2C_BUSY.
+ */
+typedef struct i2c_transaction
+{
+    unsigned char addr;                 /**< 7-bit device address */
+    const unsigned char *tx_data;       /**< bytes to write, may be NULL when tx_len = 0 */
+    unsigned int tx_len;
+    unsigned char *rx_data;             /**< buffer for read bytes, may be NULL when rx_len = 0 */
+    unsigned int rx_len;
+    volatile unsigned char status;      /**< I2C_BUSY while queued/running, then I2C_OK or I2C_ERR */
+    void (*callback)(struct i2c_transaction *t); /**< called from TWI interrupt when done, may be NULL */
+} i2c_transaction;
 
 
 /**
@@ -121,6 +144,8 @@ extern void i2c_stop(void);
 /** 
  @brief Issues a start condition and sends address and transfer direction 
   
+ On failure the bus is released, a following i2c_stop() does nothing.
+
  @param    addr address and transfer direction of I2C device
  @retval   0   device accessible 
  @retval   1   failed to access device 
@@ -182,6 +207,39 @@ extern unsigned char i2c_read(unsigned char ack);
 #define i2c_read(ack)  (ack) ? i2c_readAck() : i2c_readNak(); 
 
 
+/**
+ @brief    queue an interrupt driven transaction
+
+ Bus is released with a stop condition after every transaction. Blocking calls
+ (i2c_start() ... i2c_stop()) wait for the queue to drain and hold off queued
+ transactions until i2c_stop(), so both APIs may be mixed.
+ Available with the hardware TWI implementation (twimaster.c) only.
+
+ @param    t  transaction descriptor, status is set to I2C_BUSY
+ @retval   0  transaction queued
+ @retval   1  queue full
+ */
+extern unsigned char i2c_submit(i2c_transaction *t);
+
+/**
+ @brief    check if asynchronous transactions are queued or running
+ @return   0 when idle
+ */
+extern unsigned char i2c_busy(void);
+
+/**
+ @brief    wait until transaction is finished, must not be called with interrupts disabled
+ @return   I2C_OK or I2C_ERR
+ */
+extern unsigned char i2c_wait(i2c_transaction *t);
+
+/**
+ @brief    blocking write-then-read transaction, thin wrapper over i2c_submit() and i2c_wait()
+ @return   I2C_OK or I2C_ERR
+ */
+extern unsigned char i2c_transfer(unsigned char addr, const unsigned char *tx_data, unsigned int tx_len, unsigned char *rx_data, unsigned int rx_len);
+
+
 #ifdef __cplusplus
 }
 #endif
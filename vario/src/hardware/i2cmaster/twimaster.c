@@ -8,6 +8,8 @@
 **************************************************************************/
 #include <inttypes.h>
 #include <compat/twi.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
 
 #include <i2cmaster.h>
 
@@ -20,6 +22,45 @@
 /* I2C clock in Hz */
 #define SCL_CLOCK  200000L
 
+/* TWCR values used by the interrupt driven engine */
+#define TWCR_ASYNC       ((1<<TWINT) | (1<<TWEN) | (1<<TWIE))
+#define TWCR_ASYNC_START (TWCR_ASYNC | (1<<TWSTA))
+
+
+/* asynchronous transaction queue */
+static i2c_transaction * volatile queue[I2C_QUEUE_LEN];
+static volatile uint8_t queue_head = 0;
+static volatile uint8_t queue_count = 0;
+
+/* engine state, only touched from TWI ISR while engine is running */
+static volatile uint8_t engine_running = 0;
+static uint16_t xfer_pos;
+static uint8_t  xfer_read;
+
+/* set between blocking i2c_start() and i2c_stop() */
+static volatile uint8_t bus_claimed = 0;
+
+
+/*************************************************************************
+ Wait for queued transactions to finish and hold the bus for blocking calls
+*************************************************************************/
+static void i2c_claim(void)
+{
+    if ( bus_claimed ) return;      /* repeated start inside blocking transfer */
+
+    while ( !bus_claimed )
+    {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            if ( !engine_running ) bus_claimed = 1;
+        }
+    }
+
+    // wait until stop condition of last async transaction is executed
+    while(TWCR & (1<<TWSTO));
+
+}/* i2c_claim */
+
 
 /*************************************************************************
  Initialization of the I2C bus interface. Need to be called only once
@@ -37,11 +78,14 @@ void i2c_init(void)
 /*************************************************************************	
   Issues a start condition and sends address and transfer direction.
   return 0 = device accessible, 1= failed to access device
+  On failure the bus is already released, i2c_stop() is then a no-op
 *************************************************************************/
 unsigned char i2c_start(unsigned char address)
 {
     uint8_t   twst;
 
+	i2c_claim();
+
 	// send START condition
 	TWCR = (1<<TWINT) | (1<<TWSTA) | (1<<TWEN);
 
@@ -50,7 +94,7 @@ unsigned char i2c_start(unsigned char address)
 
 	// check value of TWI Status Register. Mask prescaler bits.
 	twst = TW_STATUS & 0xF8;
-	if ( (twst != TW_START) && (twst != TW_REP_START)) return 1;
+	if ( (twst != TW_START) && (twst != TW_REP_START)) goto fail;
 
 	// send device address
 	TWDR = address;
@@ -61,10 +105,15 @@ unsigned char i2c_start(unsigned char address)
 
 	// check value of TWI Status Register. Mask prescaler bits.
 	twst = TW_STATUS & 0xF8;
-	if ( (twst != TW_MT_SLA_ACK) && (twst != TW_MR_SLA_ACK) ) return 1;
+	if ( (twst != TW_MT_SLA_ACK) && (twst != TW_MR_SLA_ACK) ) goto fail;
 
 	return 0;
 
+fail:
+	// release the claim, queued transactions must not wait for the caller
+	i2c_stop();
+	return 1;
+
 }/* i2c_start */
 
 
@@ -79,6 +128,8 @@ void i2c_start_wait(unsigned char address)
     uint8_t   twst;
 
 
+    i2c_claim();
+
     while ( 1 )
     {
 	    // send START condition
@@ -137,12 +188,27 @@ unsigned char i2c_rep_start(unsigned char address)
 *************************************************************************/
 void i2c_stop(void)
 {
+    /* released by a failed i2c_start(), async engine may own the bus */
+    if ( !bus_claimed ) return;
+
     /* send stop condition */
 	TWCR = (1<<TWINT) | (1<<TWEN) | (1<<TWSTO);
 	
 	// wait until stop condition is executed and bus released
 	while(TWCR & (1<<TWSTO));
 
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		bus_claimed = 0;
+
+		// run transactions queued while bus was held
+		if ( queue_count )
+		{
+			engine_running = 1;
+			TWCR = TWCR_ASYNC_START;
+		}
+	}
+
 }/* i2c_stop */
 
 
@@ -200,3 +266,157 @@ unsigned char i2c_readNak(void)
 	return TWDR;
 
 }/* i2c_readNak */
+
+
+/*************************************************************************
+ Queue an interrupt driven transaction
+ 
+ Return:  0 transaction queued
+          1 queue full
+*************************************************************************/
+unsigned char i2c_submit(i2c_transaction *t)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if ( queue_count >= I2C_QUEUE_LEN ) return I2C_ERR;
+
+        t->status = I2C_BUSY;
+        queue[(queue_head + queue_count) % I2C_QUEUE_LEN] = t;
+        queue_count++;
+
+        if ( !engine_running && !bus_claimed )
+        {
+            engine_running = 1;
+            TWCR = TWCR_ASYNC_START;
+        }
+    }
+    return I2C_OK;
+
+}/* i2c_submit */
+
+
+unsigned char i2c_busy(void)
+{
+    return queue_count;
+
+}/* i2c_busy */
+
+
+unsigned char i2c_wait(i2c_transaction *t)
+{
+    while ( t->status == I2C_BUSY );
+    return t->status;
+
+}/* i2c_wait */
+
+
+/*************************************************************************
+ Blocking write-then-read, a thin wrapper over the asynchronous engine
+
+ Return:  0 transfer successful
+          1 transfer failed
+*************************************************************************/
+unsigned char i2c_transfer(unsigned char addr, const unsigned char *tx_data, unsigned int tx_len, unsigned char *rx_data, unsigned int rx_len)
+{
+    i2c_transaction t = {
+        .addr = addr,
+        .tx_data = tx_data,
+        .tx_len = tx_len,
+        .rx_data = rx_data,
+        .rx_len = rx_len,
+        .status = I2C_OK,
+        .callback = 0
+    };
+
+    while ( i2c_submit(&t) != I2C_OK );
+    return i2c_wait(&t);
+
+}/* i2c_transfer */
+
+
+/*************************************************************************
+ Finish current transaction, release the bus and start the next one
+*************************************************************************/
+static void i2c_finish(uint8_t status)
+{
+    i2c_transaction *t = queue[queue_head];
+
+    queue_head = (queue_head + 1) % I2C_QUEUE_LEN;
+    queue_count--;
+
+    if ( queue_count && !bus_claimed )
+    {
+        // STOP followed by START of next transaction
+        TWCR = TWCR_ASYNC_START | (1<<TWSTO);
+    }
+    else
+    {
+        engine_running = 0;
+        TWCR = (1<<TWINT) | (1<<TWEN) | (1<<TWSTO);
+    }
+
+    t->status = status;
+    if ( t->callback ) t->callback(t);
+
+}/* i2c_finish */
+
+
+/*************************************************************************
+ TWI state machine of the asynchronous engine
+*************************************************************************/
+ISR(TWI_vect)
+{
+    i2c_transaction *t = queue[queue_head];
+
+    switch ( TW_STATUS )
+    {
+    case TW_START:
+        xfer_pos = 0;
+        xfer_read = ( (t->tx_len == 0) && (t->rx_len != 0) );
+        TWDR = (t->addr << 1) | (xfer_read ? I2C_READ : I2C_WRITE);
+        TWCR = TWCR_ASYNC;
+        break;
+
+    case TW_REP_START:
+        xfer_pos = 0;
+        xfer_read = 1;
+        TWDR = (t->addr << 1) | I2C_READ;
+        TWCR = TWCR_ASYNC;
+        break;
+
+    case TW_MT_SLA_ACK:
+    case TW_MT_DATA_ACK:
+        if ( xfer_pos < t->tx_len )
+        {
+            TWDR = t->tx_data[xfer_pos++];
+            TWCR = TWCR_ASYNC;
+        }
+        else if ( t->rx_len )
+        {
+            // switch to read phase with repeated start
+            TWCR = TWCR_ASYNC_START;
+        }
+        else i2c_finish(I2C_OK);
+        break;
+
+    case TW_MR_DATA_ACK:
+        t->rx_data[xfer_pos++] = TWDR;
+        // no break
+    case TW_MR_SLA_ACK:
+        // ACK all bytes but the last one
+        if ( (xfer_pos + 1) < t->rx_len ) TWCR = TWCR_ASYNC | (1<<TWEA);
+        else TWCR = TWCR_ASYNC;
+        break;
+
+    case TW_MR_DATA_NACK:
+        t->rx_data[xfer_pos] = TWDR;
+        i2c_finish(I2C_OK);
+        break;
+
+    default:
+        // SLA/data NACK, arbitration lost or bus error
+        i2c_finish(I2C_ERR);
+        break;
+    }
+
+}/* ISR(TWI_vect) */
@@ -2,6 +2,8 @@
 
 #include "SSD1306.h"
 
+#include <avr/pgmspace.h>
+
 #include "../i2cmaster/i2cmaster.h"
 
 #ifdef DEBUG
@@ -34,6 +36,7 @@ int8_t SSD1306driver::cmd(const uint8_t data)
 		// reg_addr setting fail
 		return SSD1306_ERR_WRITE_FAIL;
 	}
+	i2c_stop();
 	// i2c start write fail
 	return SSD1306_ERR_CONN_FAIL;
 }
@@ -70,6 +73,41 @@ int8_t SSD1306driver::cmd(const uint8_t *data, const uint8_t data_len)
 		// Data write success
 		return SSD1306_OK;
 	}
+	i2c_stop();
+	// i2c start write fail
+	return SSD1306_ERR_CONN_FAIL;
+}
+
+int8_t SSD1306driver::cmd_P(const uint8_t *data, const uint8_t data_len)
+{
+	// Start i2c write
+	if (i2c_start(dev_addr << 1 | I2C_WRITE) == I2C_OK)
+	{
+		// Set reg_addr
+		if (i2c_write(SSD1306_CONTROL_CMD_STREAM) == I2C_OK)
+		{
+			for(uint8_t i = 0; i < data_len; i++) 
+			{
+				// Write data
+				if (i2c_write(pgm_read_byte( &(data[i]) ) ) != I2C_OK)
+				{
+					i2c_stop();
+					// Data write fail
+					return SSD1306_ERR_WRITE_FAIL;
+				}
+			}
+		}
+		else
+		{
+			i2c_stop();
+			// reg_addr setting fail
+			return SSD1306_ERR_WRITE_FAIL;
+		}
+		i2c_stop();
+		// Data write success
+		return SSD1306_OK;
+	}
+	i2c_stop();
 	// i2c start write fail
 	return SSD1306_ERR_CONN_FAIL;
 }
@@ -80,73 +118,39 @@ int8_t SSD1306driver::cmd(const uint8_t *data, const uint8_t data_len)
 	#define SSD1306_CHECK_RET    if(res == SSD1306_OK) res = 
 #endif
 
+// Display off, settings as individual setters with default arguments
+const PROGMEM uint8_t _ssd1306_init_sequence[] = {
+	SSD1306_CMD_DISPLAY_OFF,
+	SSD1306_CMD_SET_DISPLAY_CLOCK,
+	(uint8_t) SSD1306_DISPLAY_CLOCK(SSD1306_DEFAULT_CLOCK_DIV_RATIO, SSD1306_DEFAULT_CLOCK_FREQUENCY),
+	SSD1306_CMD_SET_MULTIPLEX_RATIO,
+	SSD1306_MULTIPLEX_RATIO(SSD1306_DEFAULT_MULTIPLEX_RATIO),
+	SSD1306_CMD_SET_DISPLAY_OFFSET,
+	(uint8_t) SSD1306_DISPLAY_OFFSET(SSD1306_DEFAULT_VERTICAL_OFFSET),
+	SSD1306_CMD_SET_START_LINE(SSD1306_DEFAULT_START_LINE),
+	SSD1306_CMD_CHARGEPUMP,
+	SSD1306_CHARGEPUMP_ON,
+	SSD1306_DEFAULT_HORIZONTAL_SCAN ? SSD1306_CMD_SET_SEGMENT_REMAP_RIGHT : SSD1306_CMD_SET_SEGMENT_REMAP_LEFT,
+	SSD1306_DEFAULT_VERTICAL_SCAN ? SSD1306_CMD_SET_COM_SCAN_FROM_N : SSD1306_CMD_SET_COM_SCAN_FROM_0,
+	SSD1306_CMD_SET_COM_PINS,
+	SSD1306_COM_PINS_A_ALTERNATIVE | SSD1306_COM_PINS_B_REMAP_OFF,
+	SSD1306_CMD_SET_CONTRAST,
+	SSD1306_DEFAULT_CONTRAST,
+	SSD1306_CMD_SET_PRECHARGE_PERIOD,
+	SSD1306_DEFAULT_PRECHARGE_PERIOD,
+	SSD1306_CMD_SET_V_COM_DESELECT,
+	(uint8_t) SSD1306_V_COM_DESELECT(SSD1306_DEFAULT_V_COM_DESELECT),
+	SSD1306_DEFAULT_MODE ? SSD1306_CMD_MODE_INVERSE : SSD1306_CMD_MODE_NORMAL,
+	SSD1306_CMD_SET_MEM_ADDR_MODE,
+	SSD1306_MEM_ADDR_MODE_HORIZONTAL
+};
+
 int8_t SSD1306driver::init()
 {
 	int res = SSD1306_OK;
 
-	// Turn display off
-	res = sleep();
-
-	// Set Display Clock Divide Ratio/Oscillator Frequency
-	// SSD1306_CHECK_RET setRefreshRate();
-	SSD1306_CHECK_RET cmd(SSD1306_CMD_SET_DISPLAY_CLOCK);
-	SSD1306_CHECK_RET cmd( (uint8_t) SSD1306_DISPLAY_CLOCK(
-		SSD1306_DEFAULT_CLOCK_DIV_RATIO,
-		SSD1306_DEFAULT_CLOCK_FREQUENCY)
-	);
-
-	// Set Multiplex Ratio
-	SSD1306_CHECK_RET cmd(SSD1306_CMD_SET_MULTIPLEX_RATIO);
-	SSD1306_CHECK_RET cmd( SSD1306_MULTIPLEX_RATIO(SSD1306_DEFAULT_MULTIPLEX_RATIO) );
-
-	// Set Display Offset
-	//SSD1306_CHECK_RET setVerticalOffset();
-	SSD1306_CHECK_RET cmd(SSD1306_CMD_SET_DISPLAY_OFFSET);
-	SSD1306_CHECK_RET cmd( (uint8_t) SSD1306_DISPLAY_OFFSET(SSD1306_DEFAULT_VERTICAL_OFFSET) );
-
-	// Set Display Start Line
-	SSD1306_CHECK_RET setStartLine();
-	//cmd( SSD1306_CMD_SET_START_LINE(SSD1306_DEFAULT_START_LINE) );
-
-	// Set Charge Pump
-	SSD1306_CHECK_RET cmd(SSD1306_CMD_CHARGEPUMP);
-	SSD1306_CHECK_RET cmd(SSD1306_CHARGEPUMP_ON);
-
-	// Set Segment Re-Map (horizontal scan)
-	SSD1306_CHECK_RET setHorizontalScan();
-	//cmd(SSD1306_CMD_SET_SEGMENT_REMAP_LEFT);
-
-	// Set COM Output Scan Direction (vertical scan)
-	SSD1306_CHECK_RET setVerticalScan();
-	//cmd(SSD1306_CMD_SET_COM_SCAN_FROM_0);
-
-	// Set COM Pins Hardware Configuration
-	SSD1306_CHECK_RET cmd(SSD1306_CMD_SET_COM_PINS);
-	SSD1306_CHECK_RET cmd(SSD1306_COM_PINS_A_ALTERNATIVE | SSD1306_COM_PINS_B_REMAP_OFF);
-
-	// Set Contrast Control
-	 SSD1306_CHECK_RET setContrast();
-	//cmd(SSD1306_CMD_SET_CONTRAST);
-	//cmd(SSD1306_DEFAULT_CONTRAST);
-
-	// Set Pre-Charge Period
-	SSD1306_CHECK_RET setPreChargePeriod();
-	//cmd(SSD1306_CMD_SET_PRECHARGE_PERIOD);
-	//cmd(SSD1306_DEFAULT_PRECHARGE_PERIOD);
-
-	// Set VCOMH Deselect Level
-	SSD1306_CHECK_RET setVCOMHdeselectLevel();
-	//cmd(SSD1306_CMD_SET_V_COM_DESELECT);
-	//cmd(SSD1306_DEFAULT_V_COM_DESELECT);
-
-	// Set Normal/Inverse Display
-	SSD1306_CHECK_RET setMode();
-	//cmd(SSD1306_CMD_MODE_NORMAL);
-    
-	// Horizontal memory mode
-	SSD1306_CHECK_RET setMemoryMode();
-	//cmd(SSD1306_CMD_SET_MEM_ADDR_MODE);
-	//cmd(SSD1306_MEM_ADDR_MODE_HORIZONTAL);
+	// Whole setup in one transaction
+	res = cmd_P(_ssd1306_init_sequence, sizeof(_ssd1306_init_sequence) );
 
 	SSD1306_CHECK_RET clearBuffer();
 	
@@ -160,6 +164,7 @@ SSD1306driver::SSD1306driver(uint8_t dev_addr)
 {
 	this->device_ok = false;
 	this->dev_addr = dev_addr;
+	clearDamage();
 
 	if (init() == SSD1306_OK) this->device_ok = true;
 }
@@ -315,92 +320,203 @@ int8_t SSD1306driver::stopScroll()
 
 int8_t SSD1306driver::setColumnRange(const uint8_t start, const uint8_t end)
 {
-	const uint8_t cmd_data[] = {
-		SSD1306_CMD_SET_COL_ADDR,
-		(uint8_t) SSD1306_COL_ADDR(start),
-		(uint8_t) SSD1306_COL_ADDR(end)
-	};
-	return cmd(cmd_data, 3);
+	window_col_start = SSD1306_COL_ADDR(start);
+	window_col_end = SSD1306_COL_ADDR(end);
+	window_pending = true;
+	return SSD1306_OK;
 }
 
 int8_t SSD1306driver::setPagesRange(const uint8_t start, const uint8_t end)
 {
-	const uint8_t cmd_data[] = {
-		SSD1306_CMD_SET_PAGE_ADDR,
-		(uint8_t) SSD1306_PAGE_ADDR(start),
-		(uint8_t) SSD1306_PAGE_ADDR(end)
-	};
-	return cmd(cmd_data, 3);
+	window_page_start = SSD1306_PAGE_ADDR(start);
+	window_page_end = SSD1306_PAGE_ADDR(end);
+	window_pending = true;
+	return SSD1306_OK;
 }
 
-
-int8_t SSD1306driver::sendData(const uint8_t *data, const uint16_t data_len)
+int8_t SSD1306driver::beginData()
 {
 	// Start i2c write
-	if (i2c_start(dev_addr << 1 | I2C_WRITE) == I2C_OK)
+	if (i2c_start(dev_addr << 1 | I2C_WRITE) != I2C_OK)
 	{
-		// Set reg_addr
-		if (i2c_write(0x40) == I2C_OK)
+		i2c_stop();
+		// i2c start write fail
+		return SSD1306_ERR_CONN_FAIL;
+	}
+
+	if(window_pending)
+	{
+		// Single command control byte before each window command byte
+		const uint8_t window[] = {
+			SSD1306_CMD_SET_COL_ADDR,
+			window_col_start,
+			window_col_end,
+			SSD1306_CMD_SET_PAGE_ADDR,
+			window_page_start,
+			window_page_end
+		};
+		for(uint8_t i = 0; i < sizeof(window); i++)
 		{
-			for(uint16_t i = 0; i < data_len; i++) 
+			if( (i2c_write(SSD1306_CONTROL_CMD_SINGLE) != I2C_OK) || (i2c_write(window[i]) != I2C_OK) )
 			{
-				// Write data
-				if (i2c_write(data[i]) != I2C_OK)
-				{
-					i2c_stop();
-					// Data write fail
-					return SSD1306_ERR_WRITE_FAIL;
-				}
-#ifdef DEBUG
-				printf("data(0x%X)\n", data[i]);
-#endif
+				i2c_stop();
+				return SSD1306_ERR_WRITE_FAIL;
 			}
 		}
-		else
+		window_pending = false;
+	}
+
+	// Set reg_addr
+	if (i2c_write(SSD1306_CONTROL_DATA_STREAM) != I2C_OK)
+	{
+		i2c_stop();
+		return SSD1306_ERR_WRITE_FAIL;
+	}
+	return SSD1306_OK;
+}
+
+int8_t SSD1306driver::sendData(const uint8_t *data, const uint16_t data_len)
+{
+	markDamage();
+
+	int8_t res = beginData();
+	if(res != SSD1306_OK) return res;
+
+	for(uint16_t i = 0; i < data_len; i++) 
+	{
+		// Write data
+		if (i2c_write(data[i]) != I2C_OK)
 		{
 			i2c_stop();
-			// reg_addr setting fail
+			// Data write fail
 			return SSD1306_ERR_WRITE_FAIL;
 		}
-		i2c_stop();
-		// Data write success
-		return SSD1306_OK;
+#ifdef DEBUG
+		printf("data(0x%X)\n", data[i]);
+#endif
 	}
-	// i2c start write fail
-	return SSD1306_ERR_CONN_FAIL;
+	i2c_stop();
+	// Data write success
+	return SSD1306_OK;
 }
 
 int8_t SSD1306driver::clearBuffer()
 {
-	setColumnRange(0, SSD1306_MAX_WIDTH);
-	setPagesRange(0, SSD1306_MAX_HEIGHT);
-	// Start i2c write
-	if (i2c_start(dev_addr << 1 | I2C_WRITE) == I2C_OK)
+	return clearRegion(0, SSD1306_MAX_WIDTH, 0, SSD1306_MAX_HEIGHT);
+}
+
+int8_t SSD1306driver::sendData_P(const uint8_t *data, const uint16_t data_len, const bool invert)
+{
+	markDamage();
+
+	int8_t res = beginData();
+	if(res != SSD1306_OK) return res;
+
+	uint8_t mask = invert ? 0xFF : 0x00;
+	for(uint16_t i = 0; i < data_len; i++) 
 	{
-		// Set reg_addr
-		if (i2c_write(0x40) == I2C_OK)
+		// Write data
+		if (i2c_write(pgm_read_byte( &(data[i]) ) ^ mask) != I2C_OK)
 		{
-			for(uint16_t i = 0; i < 1024; i++) 
-			{
-				// Write data
-				if (i2c_write(0x00) != I2C_OK)
-				{
-					i2c_stop();
-					// Data write fail
-					return SSD1306_ERR_WRITE_FAIL;
-				}
-			}
+			i2c_stop();
+			// Data write fail
+			return SSD1306_ERR_WRITE_FAIL;
 		}
-		else
+	}
+	i2c_stop();
+	// Data write success
+	return SSD1306_OK;
+}
+
+int8_t SSD1306driver::fill(const uint8_t pattern, const uint16_t data_len)
+{
+	markDamage();
+
+	int8_t res = beginData();
+	if(res != SSD1306_OK) return res;
+
+	for(uint16_t i = 0; i < data_len; i++) 
+	{
+		// Write data
+		if (i2c_write(pattern) != I2C_OK)
 		{
 			i2c_stop();
-			// reg_addr setting fail
+			// Data write fail
 			return SSD1306_ERR_WRITE_FAIL;
 		}
+	}
+	i2c_stop();
+	// Data write success
+	return SSD1306_OK;
+}
+
+int8_t SSD1306driver::startData()
+{
+	markDamage();
+	return beginData();
+}
+
+int8_t SSD1306driver::writeData(const uint8_t data)
+{
+	if (i2c_write(data) != I2C_OK)
+	{
 		i2c_stop();
-		// Data write success
-		return SSD1306_OK;
+		// Data write fail
+		return SSD1306_ERR_WRITE_FAIL;
 	}
-	// i2c start write fail
-	return SSD1306_ERR_CONN_FAIL;
-}
\ No newline at end of file
+	return SSD1306_OK;
+}
+
+void SSD1306driver::stopData()
+{
+	i2c_stop();
+}
+
+int8_t SSD1306driver::clearRegion(const uint8_t col_start, const uint8_t col_end, const uint8_t page_start, const uint8_t page_end)
+{
+	setColumnRange(col_start, col_end);
+	setPagesRange(page_start, page_end);
+	return fill(0x00, (uint16_t)(window_col_end - window_col_start + 1) * (window_page_end - window_page_start + 1) );
+}
+
+
+void SSD1306driver::markDamage()
+{
+	for(uint8_t page = window_page_start; page <= window_page_end; page++)
+	{
+		if(window_col_start < damage_start[page]) damage_start[page] = window_col_start;
+		if(window_col_end > damage_end[page]) damage_end[page] = window_col_end;
+	}
+}
+
+void SSD1306driver::clearDamage()
+{
+	for(uint8_t page = 0; page <= SSD1306_MAX_HEIGHT; page++)
+	{
+		damage_start[page] = SSD1306_MAX_WIDTH;
+		damage_end[page] = 0;
+	}
+}
+
+uint8_t SSD1306driver::damagedPages() const
+{
+	uint8_t pages = 0;
+	for(uint8_t page = 0; page <= SSD1306_MAX_HEIGHT; page++)
+	{
+		if(damage_start[page] <= damage_end[page]) pages |= (1 << page);
+	}
+	return pages;
+}
+
+uint8_t SSD1306driver::clearDamaged()
+{
+	uint8_t pages = damagedPages();
+	for(uint8_t page = 0; page <= SSD1306_MAX_HEIGHT; page++)
+	{
+		if( !(pages & (1 << page) ) ) continue;
+
+		clearRegion(damage_start[page], damage_end[page], page, page);
+	}
+	clearDamage();
+	return pages;
+}
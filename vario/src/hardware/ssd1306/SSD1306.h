@@ -155,6 +155,15 @@
 #define SSD1306_CHARGEPUMP_ON                   0x14
 
 
+//////////////////////////////////////////////////
+// I2C control bytes:
+//////////////////////////////////////////////////
+//
+#define SSD1306_CONTROL_CMD_STREAM              0x00 // Co=0 D/C#=0, rest of transaction are commands
+#define SSD1306_CONTROL_CMD_SINGLE              0x80 // Co=1 D/C#=0, one command byte then next control byte
+#define SSD1306_CONTROL_DATA_STREAM             0x40 // Co=0 D/C#=1, rest of transaction is GDDRAM data
+
+
 //////////////////////////////////////////////////
 // SSD1306 Return codes:
 //////////////////////////////////////////////////
@@ -189,6 +198,21 @@ class SSD1306driver
 	bool device_ok;
 	int8_t dev_addr;
 
+	// Current address window, sent in front of next data transaction
+	bool window_pending = false;
+	uint8_t window_col_start = 0;
+	uint8_t window_col_end = SSD1306_MAX_WIDTH;
+	uint8_t window_page_start = 0;
+	uint8_t window_page_end = SSD1306_MAX_HEIGHT;
+
+	// Columns written per page since clearDamage(), start > end when untouched
+	uint8_t damage_start[SSD1306_MAX_HEIGHT + 1];
+	uint8_t damage_end[SSD1306_MAX_HEIGHT + 1];
+
+	void markDamage();
+	// i2c_start + pending window commands + data control byte
+	int8_t beginData();
+
 	//uint8_t cmd(const uint8_t data);
 	//uint8_t cmd(const uint8_t *data, const uint8_t data_len);
 
@@ -196,6 +220,8 @@ class SSD1306driver
 protected:
 	int8_t cmd(const uint8_t data);
 	int8_t cmd(const uint8_t *data, const uint8_t data_len);
+	// Command sequence from PROGMEM in one transaction
+	int8_t cmd_P(const uint8_t *data, const uint8_t data_len);
 
 public:
 	SSD1306driver(uint8_t dev_addr = SSD1306_DEFAULT_ADDRESS);
@@ -260,11 +286,32 @@ public:
 	int8_t startScroll();
 	int8_t stopScroll();
 
+	// Window is batched into the next sendData()/clearBuffer() transaction
 	int8_t setColumnRange(const uint8_t start, const uint8_t end);
 	int8_t setPagesRange(const uint8_t start, const uint8_t end);
 // Data
 	int8_t clearBuffer();
 	int8_t sendData(const uint8_t *data, const uint16_t data_len);
+	// Straight from flash, invert sends complement
+	int8_t sendData_P(const uint8_t *data, const uint16_t data_len, const bool invert = false);
+	// data_len times same byte
+	int8_t fill(const uint8_t pattern, const uint16_t data_len);
+	// Byte by byte data transaction for renderers without staging buffer:
+	// startData(), writeData() per byte, stopData(). After a failed
+	// writeData() the transaction is already closed.
+	int8_t startData();
+	int8_t writeData(const uint8_t data);
+	void stopData();
+	// Sets window and fills it with zeros
+	int8_t clearRegion(const uint8_t col_start, const uint8_t col_end, const uint8_t page_start, const uint8_t page_end);
+
+// Damage tracking:
+	// Forget written areas, call after screen owner finished drawing
+	void clearDamage();
+	// Bit per page written since clearDamage()
+	uint8_t damagedPages() const;
+	// Zero only columns written since clearDamage(), returns damagedPages() before clearing
+	uint8_t clearDamaged();
 };
 
 
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <util/delay.h>
+#include <avr/sleep.h>
 
 #include "hardware/uart/uart.h"
 #include "hardware/i2cmaster/i2cmaster.h"
@@ -12,6 +13,7 @@
 #include "hardware/sound/sound.h"
 
 #include "utils/time_clock/time_clock.h"
+#include "utils/scheduler/scheduler.h"
 #include "utils/display/display.h"
 #include "utils/settings/settings.h"
 #include "vario/vario.h"
@@ -20,17 +22,22 @@
 
 Display * _display;
 BME280 * _sensor;
+Scheduler _scheduler;
 
-void run_vario()
+// Nothing due, sleep until next interrupt (timer2 overflow at latest)
+void scheduler_idle(void *context)
 {
-	_display->driver()->clearBuffer();
-	Vario vario(_sensor, _display);
-	vario.enter();
+	sleep_mode();
+}
+
+void run_vario(Vario *vario)
+{
+	vario->enter();
 }
 
 bool run_menu()
 {
-	_display->driver()->clearBuffer();
+	// Menu draws over the vario screen, vario redraws only the pages it touched
 	MenuTree menu;
 	menu.enter();
 	return false;
@@ -38,6 +45,9 @@ bool run_menu()
 
 void main_loop()
 {
+	// Lives across mode switches, sampling and audio run while menu is open
+	Vario vario(_sensor, _display, &_scheduler);
+
 	while(true)
 	{
 		toneAC(1760);
@@ -45,7 +55,7 @@ void main_loop()
 		noToneAC();
 		led_disable();
 
-		run_vario();
+		run_vario(&vario);
 		run_menu();
 		led_enable();
 	}
@@ -62,6 +72,9 @@ int main(void) {
 	pulseToneInit();
 	btn_init();
 
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	_scheduler.setIdleHook(scheduler_idle);
+
 
 	printf("F_CPU: %d MHz\n", F_CPU / 1000000);
 	printf("BAT_V: %d (?)\n", get_battery_voltage());
@@ -73,10 +86,22 @@ int main(void) {
 
 	Display display(&ssd1306);
 	_display = &display;
+#ifdef DISPLAY_BENCHMARK
+	display.benchmarkScaled();
+#endif
 
 	BME280 sensor;
 	if(sensor.deviceOK()) printf("BME280: OK\n");
 	_sensor = &sensor;
+#ifdef BME280_BENCHMARK
+	sensor.benchmarkRead();
+#ifndef BME280_PRESSURE_32BIT
+	sensor.benchmarkCompensation();
+#endif
+#ifndef VARIO_FIXED_POINT
+	BME280benchmarkAltitude();
+#endif
+#endif
 
 	sensor.setFilter(settings.sensor.filter);
 	sensor.setPressureSampling(settings.sensor.pressure_sampling);
@@ -84,7 +109,7 @@ int main(void) {
 	sensor.setHumiditySampling(settings.sensor.humidity_sampling);
 	sensor.setStandbyDuration(settings.sensor.standby_duration);
 	
-	menu_init(&sensor, &display, &settings);
+	menu_init(&sensor, &display, &settings, &_scheduler);
 
 	printf("Boot time: %lu ms\n", timer_get());
 
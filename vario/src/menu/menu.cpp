@@ -1,9 +1,7 @@
 #include "menu.h"
 
-#include <util/delay.h>
-
-#include "../hardware/buttons/buttons.h"
 #include "../hardware/led/led.h"
+#include "../utils/time_clock/time_clock.h"
 
 
 #include "icons/icon_back.h"
@@ -11,12 +9,27 @@
 BME280 *menu_sensor;
 Display *menu_display;
 Settings *menu_settings;
+Scheduler *menu_scheduler;
 
-void menu_init(BME280 *_sensor, Display *_display, Settings *_settings)
+void menu_init(BME280 *_sensor, Display *_display, Settings *_settings, Scheduler *_scheduler)
 {
 	menu_sensor = _sensor;
 	menu_display = _display;
 	menu_settings = _settings;
+	menu_scheduler = _scheduler;
+}
+
+BTNstatus menu_btn_read()
+{
+	for(uint8_t btn_ticks = 0; btn_ticks < MENU_BTN_TICKS; btn_ticks++)
+	{
+		debounce_btn_read();
+
+		uint32_t start = timer_get_us();
+		while( (timer_get_us() - start) < (MENU_BTN_TICK * 1000UL) ) menu_scheduler->runOnce();
+	}
+
+	return delay_btn_read();
 }
 
 const PROGMEM char empty_text[] = {""};
@@ -55,13 +68,9 @@ char* MenuListItem::text()
 	return text_buffer;
 }
 
-uint8_t * MenuListItem::icon()
+const uint8_t * MenuListItem::icon()
 {
-	for(uint8_t byte = 0; byte < LIST_ITEM_ICON_LEN; byte++)
-	{
-		data_buffer[byte] = pgm_read_byte( &(_icon[byte]) );
-	}
-	return data_buffer;
+	return _icon;
 }
 
 
@@ -112,25 +121,12 @@ void MenuList::drawItem(MenuListItem * item, uint8_t pos, bool selected)
 {
 	pos *= 2;
 	
-	uint8_t * icon = item->icon();
-	if(selected)
-	{
-		for(uint8_t byte = 0; byte < LIST_ITEM_ICON_LEN; byte++) icon[byte] = ~icon[byte];
-	}
 	menu_display->driver()->setPagesRange(pos, pos + 1);
 	menu_display->driver()->setColumnRange(0, 15);
-	menu_display->driver()->sendData(data_buffer, 32);
+	menu_display->driver()->sendData_P(item->icon(), LIST_ITEM_ICON_LEN, selected);
 
-	if(selected)
-	{
-		for(uint8_t line = 0; line < 4; line++) data_buffer[line] = 0xFF;
-	}
-	else
-	{
-		for(uint8_t line = 0; line < 4; line++) data_buffer[line] = 0x00;
-	}
 	menu_display->driver()->setColumnRange(16, 17);
-	menu_display->driver()->sendData(data_buffer, 4);
+	menu_display->driver()->fill(selected ? 0xFF : 0x00, 4);
 
 	char * entry_text = item->text();
 	uint8_t c = 0;
@@ -156,7 +152,13 @@ void MenuList::draw()
 
 	if(position_offset > 3) position_offset = 0;
 	if( (position - position_offset) > list_length) position_offset = 0;
-	for(uint8_t item = 0; item < 4; item++)
+
+	// Only the rows of the list are drawn, pages below keep the screen the
+	// menu was opened over and are not damaged
+	uint8_t rows = (list_length < 4) ? list_length : 4;
+	uint8_t pages_end = rows * 2 - 1;
+
+	for(uint8_t item = 0; item < rows; item++)
 	{
 		if( (position - position_offset + item) < list_length)
 		{
@@ -168,41 +170,18 @@ void MenuList::draw()
 		}
 		else
 		{
-			menu_display->print(
-				"  ",
-				font_2x7,
-				false,
-				item * 2,
-				0,
-				110
-			);
+			menu_display->driver()->clearRegion(0, 123, item * 2, item * 2 + 1);
 		}
 	}
 
-	uint8_t bar = (uint16_t)position * 16 / list_length;
-	uint8_t pos = 0;
-	for(uint8_t bar_line = 0; bar_line < 8; bar_line++)
-	{
-		pos = bar_line * 4;
-		if(bar_line == (bar / 2) )
-		{
-			data_buffer[pos] = 0x00;
-			data_buffer[pos + 1] = 0xFF;
-			data_buffer[pos + 2] = 0xFF;
-			data_buffer[pos + 3] = 0xFF;
-		}
-		else
-		{
-			data_buffer[pos] = 0x00;
-			data_buffer[pos + 1] = 0x00;
-			data_buffer[pos + 2] = 0xAA;
-			data_buffer[pos + 3] = 0x00;
-		}
-	}
-	
-	menu_display->driver()->setColumnRange(124, 127);
-	menu_display->driver()->setPagesRange(0, 7);
-	menu_display->driver()->sendData(data_buffer, 32);
+	// Scrollbar: dotted track on column 126, thumb on columns 125..127
+	uint8_t bar = (uint16_t)position * rows * 4 / list_length;
+	menu_display->driver()->clearRegion(124, 127, 0, pages_end);
+	menu_display->driver()->setColumnRange(126, 126);
+	menu_display->driver()->fill(0xAA, pages_end + 1);
+	menu_display->driver()->setColumnRange(125, 127);
+	menu_display->driver()->setPagesRange(bar / 2, bar / 2);
+	menu_display->driver()->fill(0xFF, 3);
 }
 
 void MenuList::up()
@@ -236,7 +215,10 @@ void MenuList::down()
 
 void MenuList::select()
 {
+	// Entries own the whole screen, rows of a longer sublist must not remain
+	menu_display->driver()->clearBuffer();
 	list[position]->enter();
+	menu_display->driver()->clearBuffer();
 	draw();
 }
 
@@ -246,19 +228,12 @@ uint8_t MenuList::enter()
 	draw();
 	
 	BTNstatus btn;
-	uint8_t btn_ticks = 0;
 
 	exit = false;
 	led_disable();
 	while(!exit)
 	{
-		for(btn_ticks = 0; btn_ticks < 3; btn_ticks++)
-		{
-			debounce_btn_read();
-			_delay_ms(10);
-		}
-
-		btn = delay_btn_read();
+		btn = menu_btn_read();
 
 		if(btn.btn_ac) 
 		{
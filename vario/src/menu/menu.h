@@ -6,13 +6,21 @@
 #include "../utils/display/display.h"
 #include "../hardware/bme280/bme280.h"
 #include "../utils/settings/settings.h"
-#include "../utils/buffer/buffer.h"
+#include "../utils/scheduler/scheduler.h"
+#include "../hardware/buttons/buttons.h"
 
 #include "icons/icon_default.h"
 #include "icons/icon_menu.h"
 
 
-void menu_init(BME280 *_sensor, Display *_display, Settings *_settings);
+void menu_init(BME280 *_sensor, Display *_display, Settings *_settings, Scheduler *_scheduler);
+
+// ms between debounce reads, scheduler tasks run in the meantime
+#define MENU_BTN_TICK                 10
+#define MENU_BTN_TICKS                3
+
+// Button state for menu loops, background tasks (sampling, audio) keep running
+BTNstatus menu_btn_read();
 
 #define LIST_ITEM_TEXT_BUFFER_LEN     15
 #define LIST_ITEM_TEXT_LEN            13
@@ -37,7 +45,8 @@ public:
 	
 	// text
 	virtual char* text();
-	virtual uint8_t *icon();
+	// PROGMEM, LIST_ITEM_ICON_LEN bytes
+	virtual const uint8_t *icon();
 };
 
 class MenuList : public MenuListItem
@@ -86,6 +95,7 @@ public:
 extern BME280 *menu_sensor;
 extern Display *menu_display;
 extern Settings *menu_settings;
+extern Scheduler *menu_scheduler;
 
 extern MenuListItem menu_entry_back;
 
@@ -1,12 +1,15 @@
 #include "sensor_settings_tree.h"
 
 #include <avr/pgmspace.h>
+#include <stdio.h>
 
 #include "../../utils/settings/settings.h"
 
 
 const PROGMEM char sensor_tree_text[] = {"Sensor"};
 
+const PROGMEM char presets_text[] = {"Presets"};
+const PROGMEM char timing_text[] = {"Timing"};
 const PROGMEM char filter_text[] = {"Filter"};
 const PROGMEM char pressure_sampling_text[] = {"Pres. samp."};
 const PROGMEM char temperature_sampling_text[] = {"Temp. samp."};
@@ -21,6 +24,10 @@ const PROGMEM char sensor_x4_selection_text[] = {"x4"};
 const PROGMEM char sensor_x8_selection_text[] = {"x8"};
 const PROGMEM char sensor_x16_selection_text[] = {"x16"};
 
+const PROGMEM char preset_fast_text[] = {"fast"};
+const PROGMEM char preset_balanced_text[] = {"balanced"};
+const PROGMEM char preset_smooth_text[] = {"smooth"};
+
 const PROGMEM char duration_0_5_text[] = {"0.5 ms"};
 const PROGMEM char duration_10_text[] = {"10 ms"};
 const PROGMEM char duration_20_text[] = {"20 ms"};
@@ -34,16 +41,120 @@ const PROGMEM char duration_1000_text[] = {"1000 ms"};
 SensorTree::SensorTree() : MenuList(sensor_tree_text)
 {
 	entry_list[0] = &menu_entry_back;
-	entry_list[1] = &filter_entry;
-	entry_list[2] = &pressure_sampling_entry;
-	entry_list[3] = &temperature_sampling_entry;
-	entry_list[4] = &humidity_sampling_entry;
-	entry_list[5] = &standby_duration_entry;
+	entry_list[1] = &presets_entry;
+	entry_list[2] = &timing_entry;
+	entry_list[3] = &filter_entry;
+	entry_list[4] = &pressure_sampling_entry;
+	entry_list[5] = &temperature_sampling_entry;
+	entry_list[6] = &humidity_sampling_entry;
+	entry_list[7] = &standby_duration_entry;
 
 	setup(
 		sensor_tree_text,
 		entry_list,
-		6,
+		8,
+		0
+	);
+}
+
+
+SensorPresets::SensorPresets() : MenuList(presets_text)
+{
+	preset_fast_entry.setup(preset_fast_text);
+	preset_balanced_entry.setup(preset_balanced_text);
+	preset_smooth_entry.setup(preset_smooth_text);
+
+	entry_list[0] = &menu_entry_back;
+	entry_list[1] = &preset_fast_entry;
+	entry_list[2] = &preset_balanced_entry;
+	entry_list[3] = &preset_smooth_entry;
+
+	setup(
+		presets_text,
+		entry_list,
+		4,
+		0
+	);
+}
+
+void SensorPresets::select()
+{
+	BME280driver::Filter filter_value[3] = {
+		BME280driver::FILTER_X2,
+		BME280driver::FILTER_X4,
+		BME280driver::FILTER_X16
+	};
+	BME280driver::Sampling pressure_sampling_value[3] = {
+		BME280driver::SAMPLING_X4,
+		BME280driver::SAMPLING_X8,
+		BME280driver::SAMPLING_X16
+	};
+	BME280driver::Sampling temperature_sampling_value[3] = {
+		BME280driver::SAMPLING_X1,
+		BME280driver::SAMPLING_X1,
+		BME280driver::SAMPLING_X2
+	};
+
+	uint8_t preset = position - 1;
+
+	menu_settings->sensor.filter = filter_value[preset];
+	menu_settings->sensor.standby_duration = BME280driver::STANDBY_MS_0_5;
+	menu_settings->sensor.pressure_sampling = pressure_sampling_value[preset];
+	menu_settings->sensor.temperature_sampling = temperature_sampling_value[preset];
+	menu_settings->sensor.humidity_sampling = BME280driver::SAMPLING_X1;
+
+	menu_sensor->setFilter(menu_settings->sensor.filter);
+	menu_sensor->setStandbyDuration(menu_settings->sensor.standby_duration);
+	menu_sensor->setPressureSampling(menu_settings->sensor.pressure_sampling);
+	menu_sensor->setTemperatureSampling(menu_settings->sensor.temperature_sampling);
+	menu_sensor->setHumiditySampling(menu_settings->sensor.humidity_sampling);
+	exit = true;
+}
+
+
+SensorTimingItem::SensorTimingItem(Figure figure) : MenuListItem(timing_text)
+{
+	this->figure = figure;
+}
+
+char* SensorTimingItem::text()
+{
+	BME280Settings settings = menu_sensor->getSettings();
+
+	switch(figure)
+	{
+	case FIGURE_ODR:
+	{
+		uint32_t odr = BME280outputDataRate(settings);
+		snprintf(text_buffer, LIST_ITEM_TEXT_LEN, "%lu.%luHz", odr / 1000, (odr % 1000) / 100);
+		break;
+	}
+	case FIGURE_LATENCY:
+		snprintf(text_buffer, LIST_ITEM_TEXT_LEN, "lag %lums", BME280filterLatency(settings) / 1000);
+		break;
+	case FIGURE_NOISE:
+		snprintf(text_buffer, LIST_ITEM_TEXT_LEN, "noise %ucm", BME280altitudeNoise(settings));
+		break;
+	}
+
+	return text_buffer;
+}
+
+SensorTiming::SensorTiming() :
+	MenuList(timing_text),
+	odr_entry(SensorTimingItem::FIGURE_ODR),
+	latency_entry(SensorTimingItem::FIGURE_LATENCY),
+	noise_entry(SensorTimingItem::FIGURE_NOISE)
+{
+	entry_list[0] = &menu_entry_back;
+	entry_list[1] = &odr_entry;
+	entry_list[2] = &latency_entry;
+	entry_list[3] = &noise_entry;
+
+	setup(
+		timing_text,
+		entry_list,
+		4,
 		0
 	);
 }
@@ -88,10 +88,57 @@ public:
 	SensorStandbyDuration();
 };
 
+class SensorPresets : public MenuList
+{
+	MenuListItem *entry_list[4];
+
+	MenuListItem preset_fast_entry;
+	MenuListItem preset_balanced_entry;
+	MenuListItem preset_smooth_entry;
+
+protected:
+	void select() override;
+
+public:
+	SensorPresets();
+};
+
+class SensorTimingItem : public MenuListItem
+{
+public:
+	enum Figure
+	{
+		FIGURE_ODR,
+		FIGURE_LATENCY,
+		FIGURE_NOISE
+	};
+
+private:
+	Figure figure;
+
+public:
+	SensorTimingItem(Figure figure);
+	char* text() override;
+};
+
+class SensorTiming : public MenuList
+{
+	MenuListItem *entry_list[4];
+
+	SensorTimingItem odr_entry;
+	SensorTimingItem latency_entry;
+	SensorTimingItem noise_entry;
+
+public:
+	SensorTiming();
+};
+
 class SensorTree : public MenuList
 {
-	MenuListItem *entry_list[6];
+	MenuListItem *entry_list[8];
 
+	SensorPresets presets_entry;
+	SensorTiming timing_entry;
 	SensorFilter filter_entry;
 	SensorPressureSampling pressure_sampling_entry;
 	SensorTemperatureSampling temperature_sampling_entry;
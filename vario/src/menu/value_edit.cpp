@@ -1,9 +1,6 @@
 #include "value_edit.h"
 
 #include <stdio.h>
-#include <util/delay.h>
-
-#include "../hardware/buttons/buttons.h"
 
 template <class T>
 MenuValueEdit<T>::MenuValueEdit(
@@ -54,15 +51,34 @@ void MenuValueEdit<T>::setup(
 }
 
 template <class T>
-void MenuValueEdit<T>::drawValue()
+void MenuValueEdit<T>::formatValue()
+{
+	// Integer types keep float layout, without float printf
+	sprintf(
+		text_buffer,
+		"% 07ld.000000",
+		(long)value
+	);
+}
+
+#ifndef VARIO_FIXED_POINT
+template <>
+void MenuValueEdit<float>::formatValue()
 {
 	sprintf(
 		text_buffer,
 		"% 014.6f",//"%*.*f",
 		//(int_digits + fraq_digits),
 		//fraq_digits,
-		(float)value
+		value
 	);
+}
+#endif
+
+template <class T>
+void MenuValueEdit<T>::drawValue()
+{
+	formatValue();
 	//buffer[4] = 0;
 	menu_display->print(
 		text_buffer,
@@ -198,16 +214,9 @@ uint8_t MenuValueEdit<T>::enter()
 	draw();
 	
 	BTNstatus btn;
-	uint8_t btn_ticks = 0;
 	while(true)
 	{
-		for(btn_ticks = 0; btn_ticks < 3; btn_ticks++)
-		{
-			debounce_btn_read();
-			_delay_ms(10);
-		}
-
-		btn = delay_btn_read();
+		btn = menu_btn_read();
 
 		if(btn.btn_ac) break;
 
@@ -232,4 +241,6 @@ uint8_t MenuValueEdit<T>::enter()
 }
 
 template class MenuValueEdit<uint8_t>;
-template class MenuValueEdit<float>;
\ No newline at end of file
+#ifndef VARIO_FIXED_POINT
+template class MenuValueEdit<float>;
+#endif
\ No newline at end of file
@@ -23,6 +23,7 @@ protected:
 	int8_t pos;
 
 	void draw();
+	void formatValue();
 	void drawValue();
 	void drawArrow();
 	void up();
@@ -1,3 +0,0 @@
-#include "buffer.h" 
-
-uint8_t data_buffer[BUFFER_SIZE] = {0};
@@ -1,10 +0,0 @@
-#ifndef BUFFER_H
-#define BUFFER_H
-
-#include <stdint.h>
-
-#define BUFFER_SIZE         376
-
-extern uint8_t data_buffer[BUFFER_SIZE];
-
-#endif // BUFFER_H
\ No newline at end of file
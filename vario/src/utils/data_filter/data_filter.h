@@ -5,19 +5,133 @@
 
 #define DATA_BUFFER_SIZE 14
 
+// Ring buffer of last SIZE values with running sums, T is element type,
+// A accumulator type (wider than T for fixed-point). Defined in header,
+// any type and window size can be instantiated
+template <class T, uint8_t SIZE = DATA_BUFFER_SIZE, class A = T>
 class DataFilter
 {
-	float data[DATA_BUFFER_SIZE];
+	T data[SIZE];
 	uint8_t pos;
 
+	A sum;
+	A sum_sq;
+	// sum of index * value, index 0 is oldest value
+	A sum_iy;
+
+	// Constant sums of sample index 0..SIZE-1 for slope
+	static constexpr A sum_i = (A)SIZE * (SIZE - 1) / 2;
+	static constexpr A denom_i = (A)SIZE * SIZE * ( (A)SIZE * SIZE - 1) / 12;
+
+	// Running sums in A are exact for integer types only, float sums
+	// keep the rounding error of every value added and removed again
+	static constexpr bool inexact_sums = ( (A)1 / 2 != 0);
+
+	void recalculate();
+
 public:
 	DataFilter();
 
-	float & top();
-	float & prev();
+	void reset(T value = 0);
 
-	void push(float value);
-	float mean();
+	T top() const;
+	T prev() const;
+
+	void push(T value);
+	T mean() const;
+	// In accumulator type, square of T may not fit T
+	A variance() const;
+	// Least squares slope per sample over the window
+	T slope() const;
 };
 
-#endif // DATA_FILTER_H
\ No newline at end of file
+template <class T, uint8_t SIZE, class A>
+DataFilter<T, SIZE, A>::DataFilter()
+{
+	reset();
+}
+
+template <class T, uint8_t SIZE, class A>
+void DataFilter<T, SIZE, A>::reset(T value)
+{
+	for(uint8_t i = 0; i < SIZE; i++) data[i] = value;
+	pos = 0;
+	recalculate();
+}
+
+template <class T, uint8_t SIZE, class A>
+void DataFilter<T, SIZE, A>::recalculate()
+{
+	sum = 0;
+	sum_sq = 0;
+	sum_iy = 0;
+
+	// pos is newest value, oldest follows it
+	uint8_t i = pos;
+	for(uint8_t index = 0; index < SIZE; index++)
+	{
+		i++;
+		if(i >= SIZE) i = 0;
+		sum += data[i];
+		sum_sq += (A)data[i] * data[i];
+		sum_iy += (A)index * data[i];
+	}
+}
+
+template <class T, uint8_t SIZE, class A>
+void DataFilter<T, SIZE, A>::push(T value)
+{
+	pos++;
+	if(pos >= SIZE) pos = 0;
+
+	// data[pos] is oldest value, every other shifts one index down
+	T old = data[pos];
+	sum_iy += (A)(SIZE - 1) * value - (sum - old);
+	sum += (A)value - old;
+	sum_sq += (A)value * value - (A)old * old;
+
+	data[pos] = value;
+
+	// Without a rescan the float error would grow over a flight until
+	// mean() and variance() of a steady signal drift, so drop it once per
+	// window. Integer sums are exact and skip the O(SIZE) rescan.
+	if(inexact_sums && (pos == 0) ) recalculate();
+}
+
+template <class T, uint8_t SIZE, class A>
+T DataFilter<T, SIZE, A>::mean() const
+{
+	return sum / (A)SIZE;
+}
+
+template <class T, uint8_t SIZE, class A>
+A DataFilter<T, SIZE, A>::variance() const
+{
+	// sum * sum / SIZE split over quotient and rest of sum / SIZE,
+	// both products are bounded by sum_sq and cannot overflow A
+	A q = sum / (A)SIZE;
+	A r = sum - q * (A)SIZE;
+	A var = (sum_sq - q * sum - r * sum / (A)SIZE) / (A)SIZE;
+	return (var < 0) ? 0 : var;
+}
+
+template <class T, uint8_t SIZE, class A>
+T DataFilter<T, SIZE, A>::slope() const
+{
+	return ( (A)SIZE * sum_iy - sum_i * sum ) / denom_i;
+}
+
+template <class T, uint8_t SIZE, class A>
+T DataFilter<T, SIZE, A>::top() const
+{
+	return data[pos];
+}
+
+template <class T, uint8_t SIZE, class A>
+T DataFilter<T, SIZE, A>::prev() const
+{
+	if(pos == 0) return data[SIZE - 1];
+	return data[pos - 1];
+}
+
+#endif // DATA_FILTER_H
@@ -0,0 +1,110 @@
+#include "kalman_filter.h"
+
+KalmanFilter::KalmanFilter(float process_noise, float measurement_noise)
+{
+	this->process_noise = process_noise;
+	this->measurement_noise = measurement_noise;
+	reset(0);
+	initialized = false;
+}
+
+void KalmanFilter::setProcessNoise(float process_noise)
+{
+	this->process_noise = process_noise;
+}
+
+void KalmanFilter::setMeasurementNoise(float measurement_noise)
+{
+	this->measurement_noise = measurement_noise;
+}
+
+void KalmanFilter::reset(float altitude)
+{
+	for(uint8_t i = 0; i < KALMAN_STATES; i++)
+	{
+		x[i] = 0;
+		for(uint8_t j = 0; j < KALMAN_STATES; j++) p[i][j] = 0;
+	}
+	x[0] = altitude;
+	p[0][0] = measurement_noise;
+	p[1][1] = KALMAN_INITIAL_SPEED_VARIANCE;
+#ifdef KALMAN_FILTER_ACCELERATION
+	p[2][2] = process_noise;
+#endif
+	initialized = true;
+}
+
+void KalmanFilter::predict(float dt)
+{
+	// x = F * x, F is constant speed (acceleration) kinematics
+	float g[KALMAN_STATES];
+	g[0] = dt * dt * 0.5;
+	g[1] = dt;
+#ifdef KALMAN_FILTER_ACCELERATION
+	g[2] = 1.0;
+	x[0] += dt * x[1] + g[0] * x[2];
+	x[1] += dt * x[2];
+#else
+	x[0] += dt * x[1];
+#endif
+
+	// P = F * P * F', F differs from identity only above diagonal
+	float fp[KALMAN_STATES][KALMAN_STATES];
+	for(uint8_t j = 0; j < KALMAN_STATES; j++)
+	{
+		fp[0][j] = p[0][j] + dt * p[1][j];
+		fp[1][j] = p[1][j];
+#ifdef KALMAN_FILTER_ACCELERATION
+		fp[0][j] += g[0] * p[2][j];
+		fp[1][j] += dt * p[2][j];
+		fp[2][j] = p[2][j];
+#endif
+	}
+	for(uint8_t i = 0; i < KALMAN_STATES; i++)
+	{
+		p[i][0] = fp[i][0] + dt * fp[i][1];
+		p[i][1] = fp[i][1];
+#ifdef KALMAN_FILTER_ACCELERATION
+		p[i][0] += g[0] * fp[i][2];
+		p[i][1] += dt * fp[i][2];
+		p[i][2] = fp[i][2];
+#endif
+	}
+
+	// P += G * q * G', noise enters through highest derivative state
+	for(uint8_t i = 0; i < KALMAN_STATES; i++)
+	{
+		for(uint8_t j = 0; j < KALMAN_STATES; j++) p[i][j] += g[i] * g[j] * process_noise;
+	}
+}
+
+void KalmanFilter::correct(float altitude)
+{
+	// Only altitude is measured, H = [1 0 (0)]
+	float s = p[0][0] + measurement_noise;
+	float k[KALMAN_STATES];
+	for(uint8_t i = 0; i < KALMAN_STATES; i++) k[i] = p[i][0] / s;
+
+	float innovation = altitude - x[0];
+	for(uint8_t i = 0; i < KALMAN_STATES; i++) x[i] += k[i] * innovation;
+
+	// P = (I - K * H) * P
+	float p0[KALMAN_STATES];
+	for(uint8_t j = 0; j < KALMAN_STATES; j++) p0[j] = p[0][j];
+	for(uint8_t i = 0; i < KALMAN_STATES; i++)
+	{
+		for(uint8_t j = 0; j < KALMAN_STATES; j++) p[i][j] -= k[i] * p0[j];
+	}
+}
+
+void KalmanFilter::update(float altitude, float dt)
+{
+	if(!initialized)
+	{
+		reset(altitude);
+		return;
+	}
+
+	predict(dt);
+	correct(altitude);
+}
@@ -0,0 +1,65 @@
+#ifndef KALMAN_FILTER_H
+#define KALMAN_FILTER_H
+
+#include <stdint.h>
+
+// Track vertical acceleration as third state instead of process noise only
+//#define KALMAN_FILTER_ACCELERATION
+
+#ifdef KALMAN_FILTER_ACCELERATION
+#define KALMAN_STATES                      3
+#else
+#define KALMAN_STATES                      2
+#endif
+
+// Process noise: acceleration (jerk with KALMAN_FILTER_ACCELERATION) variance.
+// Defaults give the speed noise of the 14 sample mean with 0.2 m altitude
+// noise at 50 Hz in 0.16 s instead of 0.26 s, see test/filter_step_test.cpp
+#ifdef KALMAN_FILTER_ACCELERATION
+#define KALMAN_DEFAULT_PROCESS_NOISE       15.0
+#else
+#define KALMAN_DEFAULT_PROCESS_NOISE       2400.0
+#endif
+// Measurement noise: altitude variance in m^2
+#define KALMAN_DEFAULT_MEASUREMENT_NOISE   0.04
+// Initial speed variance in (m/s)^2
+#define KALMAN_INITIAL_SPEED_VARIANCE      1.0
+
+class KalmanFilter
+{
+	// altitude, vertical speed [, vertical acceleration]
+	float x[KALMAN_STATES];
+	float p[KALMAN_STATES][KALMAN_STATES];
+
+	float process_noise;
+	float measurement_noise;
+
+	bool initialized = false;
+
+	void predict(float dt);
+	void correct(float altitude);
+
+public:
+	KalmanFilter(
+		float process_noise = KALMAN_DEFAULT_PROCESS_NOISE,
+		float measurement_noise = KALMAN_DEFAULT_MEASUREMENT_NOISE
+	);
+
+	void setProcessNoise(float process_noise);
+	float getProcessNoise() const { return process_noise; }
+	void setMeasurementNoise(float measurement_noise);
+	float getMeasurementNoise() const { return measurement_noise; }
+
+	// Restart from altitude with zero speed
+	void reset(float altitude);
+	// New altitude in m, dt in s since previous update
+	void update(float altitude, float dt);
+
+	float altitude() const { return x[0]; }
+	float speed() const { return x[1]; }
+#ifdef KALMAN_FILTER_ACCELERATION
+	float acceleration() const { return x[2]; }
+#endif
+};
+
+#endif // KALMAN_FILTER_H
@@ -0,0 +1,132 @@
+#ifndef REGRESSION_FILTER_H
+#define REGRESSION_FILTER_H
+
+#include <stdint.h>
+
+#define REGRESSION_FILTER_SIZE 14
+
+// Least squares line over last SIZE timestamped altitudes, slope is
+// vertical speed. Times and altitudes are kept relative to an origin
+// moved to newest sample once per window, so float sums stay precise.
+// Defined in header, any window size can be instantiated.
+template <uint8_t SIZE = REGRESSION_FILTER_SIZE>
+class RegressionFilter
+{
+	float t[SIZE];
+	float h[SIZE];
+	uint8_t pos;
+	uint8_t count;
+
+	// newest sample time and altitude origin
+	float time;
+	float h_origin;
+
+	float sum_t;
+	float sum_h;
+	float sum_tt;
+	float sum_th;
+
+	void rebase();
+
+public:
+	RegressionFilter();
+
+	void reset();
+	// New altitude in m, dt in s since previous push
+	void push(float altitude, float dt);
+	// m/s, 0 until two samples are pushed
+	float slope() const;
+};
+
+template <uint8_t SIZE>
+RegressionFilter<SIZE>::RegressionFilter()
+{
+	reset();
+}
+
+template <uint8_t SIZE>
+void RegressionFilter<SIZE>::reset()
+{
+	pos = 0;
+	count = 0;
+	time = 0;
+	h_origin = 0;
+	sum_t = 0;
+	sum_h = 0;
+	sum_tt = 0;
+	sum_th = 0;
+}
+
+template <uint8_t SIZE>
+void RegressionFilter<SIZE>::rebase()
+{
+	float h_newest = h[pos];
+
+	sum_t = 0;
+	sum_h = 0;
+	sum_tt = 0;
+	sum_th = 0;
+
+	for(uint8_t i = 0; i < count; i++)
+	{
+		t[i] -= time;
+		h[i] -= h_newest;
+
+		sum_t += t[i];
+		sum_h += h[i];
+		sum_tt += t[i] * t[i];
+		sum_th += t[i] * h[i];
+	}
+
+	h_origin += h_newest;
+	time = 0;
+}
+
+template <uint8_t SIZE>
+void RegressionFilter<SIZE>::push(float altitude, float dt)
+{
+	if(count == 0) 
+	{
+		h_origin = altitude;
+		time = 0;
+	}
+	else
+	{
+		time += dt;
+		pos++;
+		if(pos >= SIZE) pos = 0;
+	}
+
+	// Buffer full, data[pos] is oldest sample
+	if(count == SIZE)
+	{
+		sum_t -= t[pos];
+		sum_h -= h[pos];
+		sum_tt -= t[pos] * t[pos];
+		sum_th -= t[pos] * h[pos];
+	}
+	else count++;
+
+	t[pos] = time;
+	h[pos] = altitude - h_origin;
+
+	sum_t += t[pos];
+	sum_h += h[pos];
+	sum_tt += t[pos] * t[pos];
+	sum_th += t[pos] * h[pos];
+
+	if(pos == (SIZE - 1) ) rebase();
+}
+
+template <uint8_t SIZE>
+float RegressionFilter<SIZE>::slope() const
+{
+	if(count < 2) return 0;
+
+	float denom = count * sum_tt - sum_t * sum_t;
+	if(denom <= 0) return 0;
+
+	return (count * sum_th - sum_t * sum_h) / denom;
+}
+
+#endif // REGRESSION_FILTER_H
@@ -1,10 +1,38 @@
 #include "display.h"
 
-#include "../buffer/buffer.h"
+#include <avr/pgmspace.h>
+
+// Glyph table definitions, external linkage from declarations in fonts.h
+#include "fonts/font_1x4/font_1x4.h"
+#include "fonts/font_2x7/font_2x7.h"
+#include "fonts/font_numbers_4x14/font_numbers_4x14.h"
+#include "fonts/font_digits_4x14/font_digits_4x14.h"
+
+#ifdef DISPLAY_BENCHMARK
+#include <stdio.h>
+#include "../time_clock/time_clock.h"
+#endif
+
+// Nibble with every bit repeated scale times, scales 2..DISPLAY_SPREAD_MAX_SCALE
+const PROGMEM uint16_t _display_spread[DISPLAY_SPREAD_MAX_SCALE - 1][16] = {
+	{
+		0x0000, 0x0003, 0x000C, 0x000F, 0x0030, 0x0033, 0x003C, 0x003F,
+		0x00C0, 0x00C3, 0x00CC, 0x00CF, 0x00F0, 0x00F3, 0x00FC, 0x00FF
+	},
+	{
+		0x0000, 0x0007, 0x0038, 0x003F, 0x01C0, 0x01C7, 0x01F8, 0x01FF,
+		0x0E00, 0x0E07, 0x0E38, 0x0E3F, 0x0FC0, 0x0FC7, 0x0FF8, 0x0FFF
+	},
+	{
+		0x0000, 0x000F, 0x00F0, 0x00FF, 0x0F00, 0x0F0F, 0x0FF0, 0x0FFF,
+		0xF000, 0xF00F, 0xF0F0, 0xF0FF, 0xFF00, 0xFF0F, 0xFFF0, 0xFFFF
+	}
+};
 
 Display::Display(SSD1306driver *display)
 {
 	this->display = display;
+	for(uint8_t f = 0; f < DISPLAY_FIELDS; f++) fields[f].flags = 0;
 }
 
 uint8_t Display::scale_bit(const uint8_t input, const uint8_t scale, const uint8_t line)
@@ -17,72 +45,83 @@ uint8_t Display::scale_bit(const uint8_t input, const uint8_t scale, const uint8
 	return output;
 }
 
-void Display::invert_buffer(int16_t n)
+uint8_t Display::scale_byte(const uint8_t input, const uint8_t scale, const uint8_t line)
 {
-	n--;
-	while(n >=0)
-	{
-		data_buffer[n] = ~data_buffer[n];
-		n--;
-	}
+	if(scale == 1) return input;
+	if(scale > DISPLAY_SPREAD_MAX_SCALE) return scale_bit(input, scale, line);
+
+	// Whole byte spread to scale * 8 bits, output page is byte number line of it
+	const uint16_t *spread = _display_spread[scale - 2];
+	uint32_t bits = pgm_read_word( &(spread[input & 0x0F]) ) | ( (uint32_t)pgm_read_word( &(spread[input >> 4]) ) << (scale * 4) );
+	return bits >> (line * 8);
 }
 
-int8_t Display::print(
-	const char *string,
-	const Font &font,
-	const bool align_right,
-	const uint8_t v_offset,
-	const uint8_t x_offset,
-	const uint8_t spacing,
-	const bool invert
-) {
-	uint8_t string_size = 0;
-	while(string[string_size]) string_size++;
+int8_t Display::setWindow(const uint16_t width, const uint8_t height, const bool align_right, const uint8_t v_offset, const uint8_t x_offset)
+{
+	if( (width == 0) || ( (x_offset + width) > (DISPLAY_MAX_WIDTH + 1) ) || ( (v_offset + height) > (DISPLAY_MAX_HEIGHT + 1) ) ) return DISPLAY_ERR_OUT_OF_SCREEN;
 
-	uint8_t height = font.char_height;
-	uint8_t width = font.char_width * string_size + spacing * (string_size - 1);
+	if(align_right) display->setColumnRange(DISPLAY_MAX_WIDTH - x_offset - width + 1, DISPLAY_MAX_WIDTH - x_offset);
+	else display->setColumnRange(x_offset, x_offset + width -1);
+	display->setPagesRange(v_offset, height + v_offset -1);
+	return DISPLAY_OK;
+}
 
-	if( (uint16_t)height * (uint16_t)width > BUFFER_SIZE) return DISPLAY_ERR_BUFFER_OVERFLOW;
+template <class F>
+int8_t Display::stream(const char *string, const uint8_t string_size, const uint8_t spacing, const uint8_t mask)
+{
+	// Horizontal addressing walks the window page by page, same order as
+	// font tables store glyph lines, so bytes go out as they are read
+	if(display->startData() != SSD1306_OK) return DISPLAY_ERR_SCREEN_DRIVER;
 
-	// Render text
-	uint16_t buffer_byte = 0;
-	for(uint8_t l = 0; l < font.char_height; l++)
+	for(uint8_t l = 0; l < F::char_height; l++)
 	{
 		for(uint8_t c = 0; c < string_size; c++)
 		{
-			for(uint8_t x = 0; x < font.char_width; x++)
+			const uint8_t *glyph = F::glyph(string[c], l);
+			for(uint8_t x = 0; x < F::char_width; x++)
 			{
-				data_buffer[buffer_byte] = font.get_byte(string[c], x, l);
-				buffer_byte++;
+				uint8_t data = glyph ? pgm_read_byte(glyph++) : (uint8_t)string[c];
+				if(display->writeData(data ^ mask) != SSD1306_OK) return DISPLAY_ERR_SCREEN_DRIVER;
 			}
 			if(c < (string_size - 1) )
 			{
 				for(uint8_t s = 0; s < spacing; s++)
 				{
-					data_buffer[buffer_byte] = 0x00;
-					buffer_byte++;
+					if(display->writeData(mask) != SSD1306_OK) return DISPLAY_ERR_SCREEN_DRIVER;
 				}
 			}
 		}
 	}
 
-	// Set ranges
-	if(align_right) display->setColumnRange(DISPLAY_MAX_WIDTH - x_offset - width + 1, DISPLAY_MAX_WIDTH - x_offset);
-	else display->setColumnRange(x_offset, x_offset + width -1);
-	display->setPagesRange(v_offset, height + v_offset -1);
+	display->stopData();
+	return DISPLAY_OK;
+}
 
-	// Invert
-	if(invert) invert_buffer(buffer_byte);
+template <class F>
+int8_t Display::print(
+	const char *string,
+	const F &font,
+	const bool align_right,
+	const uint8_t v_offset,
+	const uint8_t x_offset,
+	const uint8_t spacing,
+	const bool invert
+) {
+	uint8_t string_size = 0;
+	while(string[string_size]) string_size++;
 
-	// Send buffer
-	display->sendData(data_buffer, buffer_byte);
+	uint16_t width = (uint16_t)F::char_width * string_size + spacing * (string_size - 1);
 
-	return DISPLAY_OK;
+	int8_t res = setWindow(width, F::char_height, align_right, v_offset, x_offset);
+	if(res != DISPLAY_OK) return res;
+
+	return stream<F>(string, string_size, spacing, invert ? 0xFF : 0x00);
 }
 
+template <class F>
 int8_t Display::printScaled(
 	const char *string,
-	const Font &font,
+	const F &font,
 	const bool align_right,
 	const uint8_t v_offset,
 	const uint8_t x_offset,
@@ -94,53 +133,199 @@ int8_t Display::printScaled(
 	uint8_t string_size = 0;
 	while(string[string_size]) string_size++;
 
-	uint8_t height = font.char_height * v_scale;
-	uint8_t width = font.char_width * h_scale * string_size + spacing * (string_size - 1);
+	uint8_t height = F::char_height * v_scale;
+	uint16_t width = (uint16_t)F::char_width * h_scale * string_size + spacing * (string_size - 1);
+
+	int8_t res = setWindow(width, height, align_right, v_offset, x_offset);
+	if(res != DISPLAY_OK) return res;
 
-	if( (uint16_t)height * (uint16_t)width > BUFFER_SIZE) return DISPLAY_ERR_BUFFER_OVERFLOW;
+	uint8_t mask = invert ? 0xFF : 0x00;
 
-	// Render text
-	uint16_t buffer_byte = 0;
-	for(uint8_t l = 0; l < font.char_height; l++)
+	// Render text straight to display
+	if(display->startData() != SSD1306_OK) return DISPLAY_ERR_SCREEN_DRIVER;
+	for(uint8_t l = 0; l < F::char_height; l++)
 	{
 		for(uint8_t sl = 0; sl < v_scale; sl++)
 		{
 			for(uint8_t c = 0; c < string_size; c++)
 			{
-				for(uint8_t x = 0; x < font.char_width; x++)
+				const uint8_t *glyph = F::glyph(string[c], l);
+				for(uint8_t x = 0; x < F::char_width; x++)
 				{
+					uint8_t data = scale_byte(
+						glyph ? pgm_read_byte(glyph++) : (uint8_t)string[c],
+						v_scale,
+						sl
+					) ^ mask;
 					for(uint8_t sx = 0; sx < h_scale; sx++)
 					{
-						data_buffer[buffer_byte] = scale_bit(
-							font.get_byte(string[c], x, l),
-							v_scale,
-							sl
-						);
-						buffer_byte++;
+						if(display->writeData(data) != SSD1306_OK) return DISPLAY_ERR_SCREEN_DRIVER;
 					}
 				}
 				if(c < (string_size - 1) )
 				{
 					for(uint8_t s = 0; s < spacing; s++)
 					{
-						data_buffer[buffer_byte] = 0x00;
-						buffer_byte++;
+						if(display->writeData(mask) != SSD1306_OK) return DISPLAY_ERR_SCREEN_DRIVER;
 					}
 				}
 			}
 		}
 	}
+	display->stopData();
 
-	// Set ranges
-	if(align_right) display->setColumnRange(DISPLAY_MAX_WIDTH - x_offset - width + 1, DISPLAY_MAX_WIDTH - x_offset);
-	else display->setColumnRange(x_offset, x_offset + width -1);
-	display->setPagesRange(v_offset, height + v_offset -1);
+	return DISPLAY_OK;
+}
 
-	// Invert
-	if(invert) invert_buffer(buffer_byte);
+int8_t Display::clearRegion(
+	const uint8_t width,
+	const uint8_t height,
+	const bool align_right,
+	const uint8_t v_offset,
+	const uint8_t x_offset
+) {
+	uint8_t start = align_right ? (DISPLAY_MAX_WIDTH - x_offset - width + 1) : x_offset;
 
-	// Send buffer
-	display->sendData(data_buffer, buffer_byte);
+	// Cached fields there are gone
+	uint8_t pages = 0;
+	for(uint8_t page = v_offset; page < (v_offset + height); page++) pages |= (1 << page);
+	invalidateFields(pages);
 
+	if(display->clearRegion(start, start + width - 1, v_offset, v_offset + height - 1) != SSD1306_OK) return DISPLAY_ERR_SCREEN_DRIVER;
 	return DISPLAY_OK;
-}
\ No newline at end of file
+}
+
+template <class F>
+int8_t Display::printField(
+	const uint8_t field,
+	const char *string,
+	const F &font,
+	const bool align_right,
+	const uint8_t v_offset,
+	const uint8_t x_offset,
+	const uint8_t spacing,
+	const bool invert
+) {
+	if(field >= DISPLAY_FIELDS) return DISPLAY_ERR_FIELD;
+
+	DisplayField &cache = fields[field];
+	uint8_t flags = DISPLAY_FIELD_VALID;
+	if(align_right) flags |= DISPLAY_FIELD_ALIGN_RIGHT;
+	if(invert) flags |= DISPLAY_FIELD_INVERT;
+
+	uint8_t string_size = 0;
+	while(string[string_size]) string_size++;
+
+	uint16_t full_bytes = (uint16_t)F::char_height * (F::char_width * string_size + spacing * (string_size - 1) );
+
+	// Same layout and length: send only glyphs between first and last changed char
+	if( (cache.flags == flags) && (cache.font == F::table()) && (cache.v_offset == v_offset) && (cache.x_offset == x_offset) && (cache.spacing == spacing) && (cache.length == string_size) )
+	{
+		uint8_t first = 0;
+		while( (first < string_size) && (cache.text[first] == string[first]) ) first++;
+
+		if(first == string_size)
+		{
+			bytes_saved += full_bytes;
+			return DISPLAY_OK;
+		}
+
+		uint8_t last = string_size - 1;
+		while(cache.text[last] == string[last]) last--;
+
+		uint8_t pitch = F::char_width + spacing;
+		uint8_t width = F::char_width * string_size + spacing * (string_size - 1);
+		uint8_t start = align_right ? (DISPLAY_MAX_WIDTH - x_offset - width + 1) : x_offset;
+		start += first * pitch;
+
+		display->setColumnRange(start, start + (last - first) * pitch + F::char_width - 1);
+		display->setPagesRange(v_offset, v_offset + F::char_height - 1);
+		int8_t res = stream<F>(&(string[first]), last - first + 1, spacing, invert ? 0xFF : 0x00);
+
+		for(uint8_t c = first; c <= last; c++) cache.text[c] = string[c];
+		bytes_saved += full_bytes - (uint16_t)F::char_height * ( (last - first) * pitch + F::char_width);
+		if(res != DISPLAY_OK) cache.flags = 0;
+		return res;
+	}
+
+	int8_t res = print(string, font, align_right, v_offset, x_offset, spacing, invert);
+
+	cache.flags = 0;
+	if( (res == DISPLAY_OK) && (string_size < DISPLAY_FIELD_LEN) )
+	{
+		cache.font = F::table();
+		cache.v_offset = v_offset;
+		cache.x_offset = x_offset;
+		cache.spacing = spacing;
+		cache.length = string_size;
+		cache.last_page = v_offset + F::char_height - 1;
+		for(uint8_t c = 0; c <= string_size; c++) cache.text[c] = string[c];
+		cache.flags = flags;
+	}
+	return res;
+}
+
+void Display::invalidateFields(const uint8_t pages)
+{
+	for(uint8_t f = 0; f < DISPLAY_FIELDS; f++)
+	{
+		DisplayField &cache = fields[f];
+		if(!cache.flags) continue;
+
+		for(uint8_t page = cache.v_offset; page <= cache.last_page; page++)
+		{
+			if(pages & (1 << page) ) cache.flags = 0;
+		}
+	}
+}
+
+#define DISPLAY_INSTANTIATE(F) \
+	template int8_t Display::print<F>(const char*, const F&, bool, uint8_t, uint8_t, uint8_t, bool); \
+	template int8_t Display::printScaled<F>(const char*, const F&, bool, uint8_t, uint8_t, uint8_t, bool, uint8_t, uint8_t); \
+	template int8_t Display::printField<F>(uint8_t, const char*, const F&, bool, uint8_t, uint8_t, uint8_t, bool);
+
+DISPLAY_INSTANTIATE(Font1x4)
+DISPLAY_INSTANTIATE(Font2x7)
+DISPLAY_INSTANTIATE(FontNumbers4x14)
+DISPLAY_INSTANTIATE(FontDigits4x14)
+
+#ifdef DISPLAY_BENCHMARK
+void Display::benchmarkScaled()
+{
+	const char digits[] = "0123456789";
+	volatile uint8_t sink = 0;
+
+	for(uint8_t scale = 2; scale <= DISPLAY_SPREAD_MAX_SCALE; scale++)
+	{
+		uint32_t time[2];
+		for(uint8_t method = 0; method < 2; method++)
+		{
+			uint32_t start = timer_get_us();
+			for(uint8_t l = 0; l < FontDigits4x14::char_height; l++)
+			{
+				for(uint8_t sl = 0; sl < scale; sl++)
+				{
+					for(uint8_t c = 0; c < 10; c++)
+					{
+						const uint8_t *glyph = FontDigits4x14::glyph(digits[c], l);
+						for(uint8_t x = 0; x < FontDigits4x14::char_width; x++)
+						{
+							uint8_t input = pgm_read_byte(glyph++);
+							sink ^= method ? scale_byte(input, scale, sl) : scale_bit(input, scale, sl);
+						}
+					}
+				}
+			}
+			time[method] = timer_get_us() - start;
+		}
+
+		// 10 glyphs rendered per method
+		printf(
+			"scale %u: scale_bit %lu glyph/s, scale_byte %lu glyph/s\n",
+			scale,
+			10000000UL / time[0],
+			10000000UL / time[1]
+		);
+	}
+}
+#endif
@@ -13,23 +13,62 @@
 
 #define DISPLAY_OK                      0
 #define DISPLAY_ERR_SCREEN_DRIVER       -1
-#define DISPLAY_ERR_BUFFER_OVERFLOW     -2
+#define DISPLAY_ERR_OUT_OF_SCREEN       -2
+#define DISPLAY_ERR_FIELD               -3
 
+// printScaled() vertical scales served from PROGMEM spread tables,
+// larger scales fall back to bit by bit scale_bit()
+#define DISPLAY_SPREAD_MAX_SCALE        4
 
+// Uncomment to build Display::benchmarkScaled()
+//#define DISPLAY_BENCHMARK
+
+// Field cache of printField()
+#define DISPLAY_FIELDS                  8
+#define DISPLAY_FIELD_LEN               8 // chars incl. terminator, longer strings are not cached
+
+struct DisplayField
+{
+	const uint8_t *font; // glyph table, same font as last print
+	uint8_t v_offset;
+	uint8_t x_offset;
+	uint8_t spacing;
+	uint8_t flags; // DISPLAY_FIELD_*
+	uint8_t last_page;
+	uint8_t length;
+	char text[DISPLAY_FIELD_LEN];
+};
+
+#define DISPLAY_FIELD_VALID             0x01
+#define DISPLAY_FIELD_ALIGN_RIGHT       0x02
+#define DISPLAY_FIELD_INVERT            0x04
+
+
+// print(), printScaled() and printField() are instantiated in display.cpp
+// for the fonts of fonts.h
 class Display
 {
 	SSD1306driver *display;
 
+	DisplayField fields[DISPLAY_FIELDS];
+	uint32_t bytes_saved = 0;
+
 	uint8_t scale_bit(const uint8_t input, const uint8_t scale, const uint8_t line);
-	void invert_buffer(int16_t n);
+	// Same result as scale_bit() via table lookup for scale <= DISPLAY_SPREAD_MAX_SCALE
+	uint8_t scale_byte(const uint8_t input, const uint8_t scale, const uint8_t line);
+	int8_t setWindow(const uint16_t width, const uint8_t height, const bool align_right, const uint8_t v_offset, const uint8_t x_offset);
+	// Glyph columns of string straight to current window, mask 0xFF inverts
+	template <class F>
+	int8_t stream(const char *string, const uint8_t string_size, const uint8_t spacing, const uint8_t mask);
 public:
 	Display(SSD1306driver *display);
 
 	SSD1306driver *driver() { return display; }
 
+	template <class F = Font1x4>
 	int8_t print(
 		const char *string,
-		const Font &font = font_1x4,
+		const F &font = font_1x4,
 		const bool align_right = false,
 		const uint8_t v_offset = 0,
 		const uint8_t x_offset = 0,
@@ -37,9 +76,10 @@ public:
 		const bool invert = false
 	);
 
+	template <class F = Font1x4>
 	int8_t printScaled(
 		const char *string,
-		const Font &font = font_1x4,
+		const F &font = font_1x4,
 		const bool align_right = false,
 		const uint8_t v_offset = 0,
 		const uint8_t x_offset = 0,
@@ -48,6 +88,40 @@ public:
 		const uint8_t v_scale = 1,
 		const uint8_t h_scale = 1
 	);
+
+	// Zero width x height (pages) area, placed like print()
+	int8_t clearRegion(
+		const uint8_t width,
+		const uint8_t height = 1,
+		const bool align_right = false,
+		const uint8_t v_offset = 0,
+		const uint8_t x_offset = 0
+	);
+
+	// print() remembering last string per field. Same string with the same
+	// layout is skipped, same length sends only the changed glyph columns,
+	// other changes fall back to full print()
+	template <class F = Font1x4>
+	int8_t printField(
+		const uint8_t field,
+		const char *string,
+		const F &font = font_1x4,
+		const bool align_right = false,
+		const uint8_t v_offset = 0,
+		const uint8_t x_offset = 0,
+		const uint8_t spacing = 1,
+		const bool invert = false
+	);
+	// Forget fields on given pages (bit per page), call when others drew over them
+	void invalidateFields(const uint8_t pages = 0xFF);
+
+	// Data bytes not sent thanks to field cache
+	uint32_t bytesSaved() const { return bytes_saved; }
+
+#ifdef DISPLAY_BENCHMARK
+	// Scaled glyph rendering rate (without I2C) of scale_bit() vs scale_byte(), printed to UART
+	void benchmarkScaled();
+#endif
 };
 
 
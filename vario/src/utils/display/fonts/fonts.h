@@ -2,60 +2,48 @@
 #define FONTS_H
 
 #include <stdint.h>
-
-#include "font_1x4/font_1x4.h"
-#include "font_2x7/font_2x7.h"
-#include "font_numbers_4x14/font_numbers_4x14.h"
-#include "font_digits_4x14/font_digits_4x14.h"
-
+#include <avr/pgmspace.h>
+
+// Glyph tables, defined by generated font_*.h headers included in display.cpp
+extern const PROGMEM uint8_t _font_1x4[];
+extern const PROGMEM uint8_t _font_2x7[];
+extern const PROGMEM uint8_t _font_numbers_4x14[];
+extern const PROGMEM uint8_t _font_digits_4x14[];
+
+// Every font is its own type, Display renders with all geometry as
+// compile-time constants. Glyph line l of char c is char_width bytes
+// at font + (c - range_start) * char_width + l * line_stride.
+template <uint8_t CHAR_HEIGHT, uint8_t CHAR_WIDTH, uint8_t RANGE_START, uint8_t RANGE_END, const uint8_t *FONT>
 struct Font
 {
-	uint8_t char_height = 1; // number of 8px lines
-	uint8_t char_width = 4;
-	uint8_t range_start = 32;
-	uint8_t range_end = 127;
-	const uint8_t *font = nullptr;
-
-	uint8_t get_byte(const char ascii_n, const uint8_t x, const uint8_t line) const
+	static const uint8_t char_height = CHAR_HEIGHT; // number of 8px lines
+	static const uint8_t char_width = CHAR_WIDTH;
+	static const uint8_t range_start = RANGE_START;
+	static const uint8_t range_end = RANGE_END;
+	static const uint16_t line_stride = (RANGE_END - RANGE_START + 1) * CHAR_WIDTH;
+
+	// Glyph table in PROGMEM, identifies the font
+	static const uint8_t *table() { return FONT; }
+
+	// First glyph byte of line in PROGMEM, nullptr for chars out of range
+	// (drawn as columns equal to the char code)
+	static const uint8_t *glyph(const char ascii_n, const uint8_t line)
 	{
-		uint16_t pos = uint8_t(ascii_n);
-		if( (pos < range_start) || (pos > range_end) ) return (uint8_t)pos;
+		uint8_t pos = uint8_t(ascii_n);
+		if( (pos < RANGE_START) || (pos > RANGE_END) ) return nullptr;
 
-		pos = (pos - range_start) * char_width + line * (range_end - range_start + 1) * char_width;
-		return pgm_read_byte( &(font[pos + x]) );
+		return FONT + (uint8_t)(pos - RANGE_START) * CHAR_WIDTH + line * line_stride;
 	}
 };
 
-const Font font_1x4 {
-	.char_height = 1,
-	.char_width = 4,
-	.range_start = 32,
-	.range_end = 127,
-	.font = _font_1x4
-};
+typedef Font<1, 4, 32, 127, _font_1x4> Font1x4;
+typedef Font<2, 7, 32, 127, _font_2x7> Font2x7;
+typedef Font<4, 14, 32, 63, _font_numbers_4x14> FontNumbers4x14;
+typedef Font<4, 14, 45, 57, _font_digits_4x14> FontDigits4x14;
 
-const Font font_2x7 {
-	.char_height = 2,
-	.char_width = 7,
-	.range_start = 32,
-	.range_end = 127,
-	.font = _font_2x7
-};
-
-const Font font_numbers_4x14 {
-	.char_height = 4,
-	.char_width = 14,
-	.range_start = 32,
-	.range_end = 63,
-	.font = _font_numbers_4x14
-};
-
-const Font font_digits_4x14 {
-	.char_height = 4,
-	.char_width = 14,
-	.range_start = 45,
-	.range_end = 57,
-	.font = _font_digits_4x14
-};
+const Font1x4 font_1x4 {};
+const Font2x7 font_2x7 {};
+const FontNumbers4x14 font_numbers_4x14 {};
+const FontDigits4x14 font_digits_4x14 {};
 
-#endif // FONTS_H
\ No newline at end of file
+#endif // FONTS_H
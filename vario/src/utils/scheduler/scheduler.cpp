@@ -0,0 +1,156 @@
+#include "scheduler.h"
+
+#include <stdio.h>
+#include <avr/pgmspace.h>
+
+#include "../time_clock/time_clock.h"
+
+
+int8_t Scheduler::addTask(const char *name, void (*run)(void *context), void *context, uint32_t period, uint8_t priority)
+{
+	uint8_t id = 0;
+	while( (id < task_count) && (tasks[id].run != nullptr) ) id++;
+	if(id >= SCHEDULER_MAX_TASKS) return SCHEDULER_ERR_FULL;
+
+	SchedulerTask &task = tasks[id];
+	task.name = name;
+	task.run = run;
+	task.context = context;
+	task.period = period;
+	task.next_run = timer_get_us() + period;
+	task.priority = priority;
+	task.enabled = true;
+
+	task.runs = 0;
+	task.overruns = 0;
+	task.run_time = 0;
+	task.max_run_time = 0;
+	task.max_latency = 0;
+
+	if(id == task_count) task_count++;
+	return id;
+}
+
+void Scheduler::removeTask(int8_t task)
+{
+	if( (task < 0) || (task >= task_count) ) return;
+
+	tasks[task].run = nullptr;
+	tasks[task].enabled = false;
+	while( (task_count > 0) && (tasks[task_count - 1].run == nullptr) ) task_count--;
+}
+
+void Scheduler::removeTasks(void *context)
+{
+	for(uint8_t i = 0; i < task_count; i++)
+	{
+		if( (tasks[i].run != nullptr) && (tasks[i].context == context) ) removeTask(i);
+	}
+}
+
+void Scheduler::setEnabled(int8_t task, bool enabled)
+{
+	if( (task < 0) || (task >= task_count) || (tasks[task].run == nullptr) ) return;
+
+	// Resume one period from now instead of catching up
+	if(enabled && !tasks[task].enabled) tasks[task].next_run = timer_get_us() + tasks[task].period;
+	tasks[task].enabled = enabled;
+}
+
+void Scheduler::setPeriod(int8_t task, uint32_t period)
+{
+	if( (task < 0) || (task >= task_count) ) return;
+	tasks[task].period = period;
+}
+
+void Scheduler::trigger(int8_t task)
+{
+	if( (task < 0) || (task >= task_count) ) return;
+	tasks[task].next_run = timer_get_us();
+}
+
+void Scheduler::setIdleHook(void (*hook)(void *context), void *context)
+{
+	idle_hook = hook;
+	idle_context = context;
+}
+
+void Scheduler::runOnce()
+{
+	uint32_t now = timer_get_us();
+
+	SchedulerTask *next = nullptr;
+	for(uint8_t i = 0; i < task_count; i++)
+	{
+		SchedulerTask &task = tasks[i];
+		if(!task.enabled) continue;
+		if( (int32_t)(now - task.next_run) < 0) continue;
+		if( (next == nullptr) || (task.priority < next->priority) ) next = &task;
+	}
+
+	if(next == nullptr)
+	{
+		if(idle_hook != nullptr)
+		{
+			idle_hook(idle_context);
+			idle_time += timer_get_us() - now;
+		}
+		return;
+	}
+
+	uint32_t latency = now - next->next_run;
+	if(latency > next->max_latency) next->max_latency = latency;
+
+	if(latency >= next->period)
+	{
+		next->overruns++;
+		next->next_run = now + next->period;
+	}
+	else next->next_run += next->period;
+
+	next->run(next->context);
+
+	uint32_t run_time = timer_get_us() - now;
+	next->runs++;
+	next->run_time += run_time;
+	if(run_time > next->max_run_time) next->max_run_time = run_time;
+}
+
+void Scheduler::resetStats()
+{
+	for(uint8_t i = 0; i < task_count; i++)
+	{
+		tasks[i].runs = 0;
+		tasks[i].overruns = 0;
+		tasks[i].run_time = 0;
+		tasks[i].max_run_time = 0;
+		tasks[i].max_latency = 0;
+	}
+	idle_time = 0;
+	stats_start = timer_get_us();
+}
+
+void Scheduler::printStats()
+{
+	uint32_t elapsed = timer_get_us() - stats_start;
+	// permille of elapsed time
+	uint32_t scale = (elapsed / 1000) ? (elapsed / 1000) : 1;
+
+	printf("task        runs  load  avg_us  max_us  late_us  overruns\n");
+	for(uint8_t i = 0; i < task_count; i++)
+	{
+		SchedulerTask &task = tasks[i];
+		if(task.run == nullptr) continue;
+		printf(
+			"%-10S %5u %5lu %7lu %7lu %8lu %9u\n",
+			task.name,
+			task.runs,
+			task.run_time / scale,
+			task.runs ? (task.run_time / task.runs) : 0,
+			task.max_run_time,
+			task.max_latency,
+			task.overruns
+		);
+	}
+	printf("idle %lu permille of %lu ms\n", idle_time / scale, elapsed / 1000);
+}
@@ -0,0 +1,68 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+
+#define SCHEDULER_MAX_TASKS         10
+
+#define SCHEDULER_ERR_FULL          -1
+
+// Lower value runs first when several tasks are due
+#define SCHEDULER_PRIORITY_HIGH     0
+#define SCHEDULER_PRIORITY_LOW      255
+
+struct SchedulerTask
+{
+	const char *name; // PROGMEM
+	void (*run)(void *context);
+	void *context;
+
+	uint32_t period; // us
+	uint32_t next_run; // us, timer_get_us()
+	uint8_t priority;
+	bool enabled;
+
+	// Statistics since Scheduler::resetStats()
+	uint16_t runs;
+	uint16_t overruns; // started a whole period late, missed runs are skipped
+	uint32_t run_time; // us, total
+	uint32_t max_run_time; // us
+	uint32_t max_latency; // us, start after due time
+};
+
+// Cooperative scheduler of periodic tasks, runOnce() starts the highest
+// priority due task and returns after it, idle hook runs when nothing is due
+class Scheduler
+{
+	// Free slots have run == nullptr, ids stay valid until removed
+	SchedulerTask tasks[SCHEDULER_MAX_TASKS];
+	uint8_t task_count = 0;
+
+	void (*idle_hook)(void *context) = nullptr;
+	void *idle_context = nullptr;
+
+	uint32_t idle_time = 0;
+	uint32_t stats_start = 0;
+
+public:
+	// Task id or SCHEDULER_ERR_FULL, first run is one period from now
+	int8_t addTask(const char *name, void (*run)(void *context), void *context, uint32_t period, uint8_t priority);
+	void removeTask(int8_t task);
+	// Removes all tasks registered with context
+	void removeTasks(void *context);
+
+	void setEnabled(int8_t task, bool enabled);
+	void setPeriod(int8_t task, uint32_t period);
+	// Run task at next runOnce() regardless of period
+	void trigger(int8_t task);
+
+	void setIdleHook(void (*hook)(void *context), void *context = nullptr);
+
+	void runOnce();
+
+	void resetStats();
+	// Per task statistics over UART (stdout)
+	void printStats();
+};
+
+#endif // SCHEDULER_H
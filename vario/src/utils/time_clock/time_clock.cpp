@@ -5,56 +5,67 @@
 #include <avr/interrupt.h>
 #include <util/atomic.h>
 
-static uint32_t time_count = 0;
+static volatile uint32_t overflow_count = 0;
+static void (* volatile tick_callback)(void) = nullptr;
 
 void time_clock_init()
 {
 	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 	{
-		// Set prescaler to 64
-		TCCR2A |= (1 << WGM21);
-		TCCR2B |= (1 << CS22);
+		// Normal mode, set prescaler to 64
+		TCCR2A = 0;
+		TCCR2B = (1 << CS22);
 
-		TIMSK2 |= (1 << OCIE2A);
-		
-		// Set compare match value
-		OCR2A = 124; // 8MHz/(64*(1+124) = 1kHz (1 ms period)
+		TIMSK2 = (1 << TOIE2); // 8MHz/64 = 125kHz (8 us), overflow every 2048 us
 
 		// Reset Timer2 counter 
 		TCNT2 = 0;
-		// Reset us counter
-		time_count = 0;
+		// Reset overflow counter
+		overflow_count = 0;
 
 		sei();
 	}
 }
 
-void timer_reset()
+static void timer_read(uint32_t *overflows, uint8_t *count)
 {
 	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 	{
-		time_count = 0;
+		*overflows = overflow_count;
+		*count = TCNT2;
+
+		// Overflow happened but is not serviced yet
+		if( (TIFR2 & (1 << TOV2)) && (*count < 255) ) (*overflows)++;
 	}
 }
 
-uint32_t timer_get_reset()
+uint32_t timer_get_us()
 {
-	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
-	{
-		uint32_t time_count_out = time_count;
-		time_count = 0;
-		return time_count_out;
-	}
+	uint32_t overflows;
+	uint8_t count;
+	timer_read(&overflows, &count);
+
+	return (overflows * TIMER_US_PER_OVERFLOW) + ( (uint32_t)count * TIMER_US_PER_COUNT);
 }
 
 uint32_t timer_get()
+{
+	uint32_t overflows;
+	uint8_t count;
+	timer_read(&overflows, &count);
+
+	return ( (uint64_t)overflows * TIMER_US_PER_OVERFLOW + ( (uint32_t)count * TIMER_US_PER_COUNT) ) / 1000;
+}
+
+void timer_tick_attach(void (*callback)(void))
 {
 	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 	{
-		return time_count;
+		tick_callback = callback;
 	}
 }
 
-ISR(TIMER2_COMPA_vect) {
-	time_count++;
+ISR(TIMER2_OVF_vect) {
+	overflow_count++;
+	if(tick_callback) tick_callback();
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef TIME_CLOCK_H
 #define TIME_CLOCK_H
 
+#include <stdint.h>
 #include <util/delay.h>
 
 #define delay_ms(ms)                \
@@ -12,10 +13,18 @@
 	}                                \
 }
 
+// Timer2 free running, 8 us resolution, overflow interrupt every 2048 us
+#define TIMER_US_PER_COUNT          8
+#define TIMER_US_PER_OVERFLOW       2048
+
 void time_clock_init();
 
-void timer_reset();
-uint32_t timer_get_reset();
+// us since init, wraps after ~71 min, differences stay valid across wrap
+uint32_t timer_get_us();
+// ms since init
 uint32_t timer_get();
 
+// Callback is run from Timer2 overflow interrupt every TIMER_US_PER_OVERFLOW, must be short
+void timer_tick_attach(void (*callback)(void));
+
 #endif // TIME_CLOCK_H
\ No newline at end of file
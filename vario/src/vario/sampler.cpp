@@ -0,0 +1,223 @@
+#include "sampler.h"
+
+#include <util/atomic.h>
+
+#include "../hardware/i2cmaster/i2cmaster.h"
+#include "../utils/time_clock/time_clock.h"
+
+
+static BME280 *sampler_sensor = nullptr;
+
+static volatile bool sampler_running = false;
+
+// Phase lock state, us
+static volatile uint32_t sampler_period_est = TIMER_US_PER_OVERFLOW;
+static uint32_t sampler_next = 0;
+static volatile bool sampler_retry = false;
+static volatile bool sampler_lock = false;
+static uint32_t sampler_edge = 0;
+static uint32_t sampler_anchor = 0;
+static uint8_t sampler_since_anchor = 0;
+static bool sampler_prev_stale = false;
+
+// Burst in flight and last burst, for stale data detection
+static i2c_transaction sampler_transaction;
+static uint8_t sampler_reg_data[BME280_STATUS_DATA_LEN];
+static uint8_t sampler_last_data[BME280_STATUS_DATA_LEN];
+// us, completion of last and previous successful burst. Queue time would
+// include waits behind blocking display transfers, completion is a fixed
+// burst length after the status register was read.
+static uint32_t sampler_read_time = 0;
+static uint32_t sampler_prev_read_time = 0;
+
+static SamplerSample sampler_buffer[SAMPLER_BUFFER_LEN];
+static volatile uint8_t sampler_head = 0;
+static volatile uint8_t sampler_count = 0;
+static volatile uint8_t sampler_overrun = 0;
+
+
+static void sampler_push(uint32_t time)
+{
+	// Drop oldest sample when consumer falls behind
+	if(sampler_count == SAMPLER_BUFFER_LEN)
+	{
+		sampler_head = (sampler_head + 1) & (SAMPLER_BUFFER_LEN - 1);
+		sampler_count--;
+		sampler_overrun++;
+	}
+
+	SamplerSample *sample = &sampler_buffer[(sampler_head + sampler_count) & (SAMPLER_BUFFER_LEN - 1)];
+	for(uint8_t i = 0; i < BME280_STATUS_DATA_LEN; i++) sample->reg_data[i] = sampler_reg_data[i];
+	sample->time = time;
+	sampler_count++;
+}
+
+// Conversion finished since last burst: measuring bit fell or data changed
+static bool sampler_fresh()
+{
+	BME280_reg_status status { .raw = sampler_reg_data[0] };
+	BME280_reg_status last_status { .raw = sampler_last_data[0] };
+
+	bool fresh = last_status.measuring && !status.measuring;
+	for(uint8_t i = BME280_STATUS_DATA_OFFSET; i < BME280_STATUS_DATA_LEN; i++)
+	{
+		if(sampler_reg_data[i] != sampler_last_data[i]) fresh = true;
+	}
+	for(uint8_t i = 0; i < BME280_STATUS_DATA_LEN; i++) sampler_last_data[i] = sampler_reg_data[i];
+
+	return fresh;
+}
+
+// TWI interrupt, burst finished
+static void sampler_done(i2c_transaction *t)
+{
+	if(t->status != I2C_OK) return;
+
+	sampler_prev_read_time = sampler_read_time;
+	sampler_read_time = timer_get_us();
+
+	if(!sampler_fresh())
+	{
+		// Read before end of conversion, poll again next tick
+		sampler_retry = true;
+		sampler_prev_stale = true;
+		return;
+	}
+	sampler_retry = false;
+	if(sampler_since_anchor < 255) sampler_since_anchor++;
+
+	if(sampler_prev_stale && (sampler_read_time - sampler_prev_read_time <= SAMPLER_BRACKET_MAX) )
+	{
+		// Conversion ended between previous and this read
+		uint32_t measured = sampler_prev_read_time + (sampler_read_time - sampler_prev_read_time) / 2;
+
+		if(!sampler_lock) sampler_edge = measured;
+		else
+		{
+			// Smooth tick quantization of measured edge with prediction,
+			// resync when prediction lost track
+			uint32_t predicted = sampler_edge + sampler_period_est;
+			int32_t error = (int32_t)(measured - predicted);
+			if( (error > SAMPLER_RESYNC) || (error < -SAMPLER_RESYNC) ) sampler_edge = measured;
+			else sampler_edge = predicted + error / 4;
+
+			uint32_t observed = (measured - sampler_anchor) / sampler_since_anchor;
+			uint32_t tolerance = sampler_period_est >> SAMPLER_PERIOD_TOLERANCE_LOG2;
+			// Only stale reads between two anchors, no conversion was missed
+			bool consecutive = (sampler_since_anchor == 1);
+			if( consecutive || ( (observed + tolerance > sampler_period_est) && (observed < sampler_period_est + tolerance) ) )
+			{
+				// Edge is quantized to timer tick, trust longer spans more
+				uint8_t weight = (sampler_since_anchor > 8) ? 8 : sampler_since_anchor;
+				sampler_period_est += ( (int32_t)observed - (int32_t)sampler_period_est) * weight / 16;
+			}
+		}
+
+		sampler_anchor = measured;
+		sampler_since_anchor = 0;
+		sampler_lock = true;
+
+		sampler_next = measured + sampler_period_est + SAMPLER_GUARD;
+	}
+	else
+	{
+		// End of conversion somewhere since previous read, use prediction
+		// and move reads earlier until one lands before the edge again,
+		// faster when period estimate is too long and reads drift late
+		uint8_t shift = sampler_since_anchor >> 3;
+		if(shift > SAMPLER_PHASE_STEP_MAX_LOG2) shift = SAMPLER_PHASE_STEP_MAX_LOG2;
+
+		sampler_edge += sampler_period_est;
+		sampler_next -= (uint32_t)SAMPLER_PHASE_STEP << shift;
+	}
+	sampler_prev_stale = false;
+
+	// Before lock first burst only starts the search
+	if(sampler_lock) sampler_push(sampler_edge);
+	else sampler_retry = true;
+}
+
+// Timer2 overflow interrupt
+static void sampler_tick()
+{
+	if(!sampler_running) return;
+
+	uint32_t now = timer_get_us();
+	if(!sampler_retry && ( (int32_t)(now - sampler_next) < 0) ) return;
+
+	// Previous burst still waits for the bus, keep this read for next tick
+	if(sampler_transaction.status == I2C_BUSY)
+	{
+		sampler_overrun++;
+		return;
+	}
+	if(!sampler_retry) sampler_next += sampler_period_est;
+
+	if(sampler_sensor->submitStatusData(&sampler_transaction, sampler_reg_data, sampler_done) != BME280_OK) sampler_overrun++;
+}
+
+void sampler_start(BME280 *sensor)
+{
+	sampler_stop();
+
+	uint32_t period = BME280samplePeriod(sensor->getSettings());
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		sampler_sensor = sensor;
+		sampler_period_est = period;
+		sampler_next = timer_get_us() + period;
+		sampler_retry = true;
+		sampler_lock = false;
+		sampler_prev_stale = false;
+		sampler_since_anchor = 0;
+		for(uint8_t i = 0; i < BME280_STATUS_DATA_LEN; i++) sampler_last_data[i] = 0;
+
+		sampler_head = 0;
+		sampler_count = 0;
+		sampler_overrun = 0;
+		sampler_running = true;
+	}
+
+	timer_tick_attach(sampler_tick);
+}
+
+void sampler_stop()
+{
+	sampler_running = false;
+
+	// Let burst in flight finish, buffers are reused by next start
+	while(sampler_transaction.status == I2C_BUSY);
+}
+
+bool sampler_pop(SamplerSample *sample)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if(sampler_count == 0) return false;
+
+		*sample = sampler_buffer[sampler_head];
+		sampler_head = (sampler_head + 1) & (SAMPLER_BUFFER_LEN - 1);
+		sampler_count--;
+	}
+	return true;
+}
+
+uint8_t sampler_overruns()
+{
+	return sampler_overrun;
+}
+
+uint32_t sampler_period()
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		return sampler_period_est;
+	}
+	return 0;
+}
+
+bool sampler_locked()
+{
+	return sampler_lock;
+}
@@ -0,0 +1,53 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <stdint.h>
+
+#include "../hardware/bme280/bme280.h"
+
+// Timer driven BME280 acquisition phase-locked to the normal mode output
+// rate: a status/data burst is queued on the interrupt driven I2C engine
+// just after each expected end of conversion, completed bursts wait in a
+// ring buffer until Vario::measure drains them. Reads returning stale data
+// are retried every tick, the stale/fresh pair brackets the end of conversion
+// and re-anchors the phase and the period estimate.
+
+// Ring buffer length, power of 2
+#define SAMPLER_BUFFER_LEN          8
+
+// Times in us
+// Read delay after expected end of conversion
+#define SAMPLER_GUARD               500
+// Reads creep earlier by this step every sample until one is stale
+#define SAMPLER_PHASE_STEP          64
+// Step doubles every 8 samples without stale read, up to step << MAX_LOG2
+#define SAMPLER_PHASE_STEP_MAX_LOG2 8
+// Measured edge further than this from prediction replaces it
+#define SAMPLER_RESYNC              2000
+// Stale and fresh read further apart than this (burst held behind other
+// bus traffic) do not bracket the end of conversion, prediction is kept
+#define SAMPLER_BRACKET_MAX         3000
+// Observed periods further than 1/4 from estimate are rejected (missed samples)
+#define SAMPLER_PERIOD_TOLERANCE_LOG2  2
+
+struct SamplerSample
+{
+	uint8_t reg_data[BME280_STATUS_DATA_LEN];
+	// us, estimated end of conversion (timer_get_us)
+	uint32_t time;
+};
+
+// Nominal period from BME280samplePeriod() of current sensor settings
+void sampler_start(BME280 *sensor);
+void sampler_stop();
+
+// Oldest buffered sample, false when buffer is empty
+bool sampler_pop(SamplerSample *sample);
+// Samples dropped because buffer was full or bus was busy for a whole period
+uint8_t sampler_overruns();
+
+// us, estimated sensor output period
+uint32_t sampler_period();
+bool sampler_locked();
+
+#endif // SAMPLER_H
@@ -3,61 +3,196 @@
 #include <stdio.h>
 #include <math.h>
 #include <util/delay.h>
+#include <avr/pgmspace.h>
 
-#include "../utils/buffer/buffer.h"
 #include "../utils/time_clock/time_clock.h"
 #include "../hardware/led/led.h"
 
-Vario::Vario(BME280 *sensor, Display *display)
+// Task names for Scheduler::printStats()
+const char _vario_task_sensor[] PROGMEM = "sensor";
+const char _vario_task_audio[] PROGMEM = "audio";
+const char _vario_task_buttons[] PROGMEM = "buttons";
+const char _vario_task_display[] PROGMEM = "display";
+const char _vario_task_display_sec[] PROGMEM = "disp_sec";
+const char _vario_task_battery[] PROGMEM = "battery";
+const char _vario_task_display_battery[] PROGMEM = "disp_bat";
+#ifdef DEBUG
+const char _vario_task_stats[] PROGMEM = "stats";
+#endif
+
+#ifdef VARIO_STAGE_TIMING
+// Stage names for printStageTimes()
+const char _vario_stage_compensate[] PROGMEM = "compensate";
+const char _vario_stage_altitude[] PROGMEM = "altitude";
+const char _vario_stage_filter[] PROGMEM = "filter";
+const char _vario_stage_tone[] PROGMEM = "tone";
+const char _vario_stage_display[] PROGMEM = "display";
+
+const char * const _vario_stage_names[VARIO_STAGES] = {
+	_vario_stage_compensate,
+	_vario_stage_altitude,
+	_vario_stage_filter,
+	_vario_stage_tone,
+	_vario_stage_display
+};
+#endif
+
+Vario::Vario(BME280 *sensor, Display *display, Scheduler *scheduler)
 {
 	this->sensor = sensor;
 	this->display = display;
+	this->scheduler = scheduler;
 
 	sensor->startNormalACQ();
-	timer_reset();
+	sampler_start(sensor);
 	measure();
 	measureBattery();
+
+	// Sensor drain + filter first, sampler ring holds SAMPLER_BUFFER_LEN bursts
+	scheduler->addTask(_vario_task_sensor, taskSensor, this, VARIO_SENSOR_PERIOD, 0);
+	scheduler->addTask(_vario_task_audio, taskAudio, this, VARIO_AUDIO_PERIOD, 1);
+	scheduler->addTask(_vario_task_battery, taskBattery, this, VARIO_BATTERY_PERIOD, 5);
+#ifdef DEBUG
+	scheduler->addTask(_vario_task_stats, taskStats, this, VARIO_STATS_PERIOD, SCHEDULER_PRIORITY_LOW);
+#endif
+	scheduler->resetStats();
 }
 
+Vario::~Vario()
+{
+	scheduler->removeTasks(this);
+	sampler_stop();
+	pulseToneStop();
+}
+
+
+
+#ifdef VARIO_FIXED_POINT
+// 2^(k/16) in Q14, tone mapping without pow()
+#define VARIO_TONE_STEP                    50
 
+const PROGMEM uint16_t _vario_tone_octave[17] = {
+	16384, 17109, 17867, 18658, 19484, 20347, 21247, 22188,
+	23170, 24196, 25268, 26386, 27554, 28774, 30048, 31379,
+	32768
+};
+
+// VARIO_TONE_BASE * 2^(speed / 8 m/s), speed in cm/s >= 0
+static uint32_t vario_tone(vario_speed_t speed)
+{
+	uint16_t step = speed / VARIO_TONE_STEP;
+	uint8_t rest = speed % VARIO_TONE_STEP;
+	uint8_t k = step & 0x0F;
+
+	uint16_t a = pgm_read_word( &(_vario_tone_octave[k]) );
+	uint16_t b = pgm_read_word( &(_vario_tone_octave[k + 1]) );
+	uint32_t mult = a + (uint32_t)(b - a) * rest / VARIO_TONE_STEP;
+
+	return ( ( (uint32_t)VARIO_TONE_BASE * mult) >> 14) << (step >> 4);
+}
+#else
+static uint32_t vario_tone(vario_speed_t speed)
+{
+	return (VARIO_TONE_BASE * pow(2.0, (speed / 8.0) ) );
+}
+#endif
 
 void Vario::measure()
 {
-	altitude_prev = altitude;
-	sensor->readData(&pressure, &temperature, &humidity);
-	altitude = BME280calcAltitude(pressure);
+	SamplerSample sample;
+	bool new_sample = false;
+
+	// Drain all bursts captured by timer since last call
+	while(sampler_pop(&sample))
+	{
+		VARIO_STAGE_START();
+#ifdef VARIO_FIXED_POINT
+		sensor->decodeData(sample.reg_data, &pressure, &temperature, &humidity, &new_sample);
+#elif defined(BME280_INT_COMPENSATION)
+		uint32_t pressure_q8 = 0, humidity_q10 = 0;
+		int32_t temperature_c = 0;
+		sensor->decodeData(sample.reg_data, &pressure_q8, &temperature_c, &humidity_q10, &new_sample);
+#else
+		sensor->decodeData(sample.reg_data, &pressure, &temperature, &humidity, &new_sample);
+#endif
+
+		// Sensor has not finished next conversion yet
+		if(!new_sample) continue;
+
+#if defined(BME280_INT_COMPENSATION) && !defined(VARIO_FIXED_POINT)
+		pressure = pressure_q8 / 256.0;
+		temperature = temperature_c / 100.0;
+		humidity = humidity_q10 / 1024.0;
+#endif
+		VARIO_STAGE_END(VARIO_STAGE_COMPENSATE);
+
+		// dt in us from conversion timestamps, first sample only sets altitude
+		uint32_t dt = sample.time - sample_time;
+		sample_time = sample.time;
+
+		altitude_prev = altitude;
+#ifdef VARIO_FIXED_POINT
+		altitude = BME280calcAltitudeFixed(pressure);
+		if(!sampled) altitude_prev = altitude;
+		VARIO_STAGE_END(VARIO_STAGE_ALTITUDE);
+
+		// m * 65536 per us to cm/s
+		speed.push( (int32_t)( ( (int64_t)(altitude - altitude_prev) * 100000000) / ( (int64_t)dt << 16) ) );
+		speed_v = speed.mean();
+#else
+		altitude = BME280calcAltitudeFast(pressure);
+		if(!sampled) altitude_prev = altitude;
+		VARIO_STAGE_END(VARIO_STAGE_ALTITUDE);
 	
-	speed.push( (altitude - altitude_prev) * 1000.0 / (float)timer_get_reset() );
+#if VARIO_FILTER == VARIO_FILTER_KALMAN
+		speed.update(altitude, (float)dt / 1000000.0);
+		speed_v = speed.speed();
+#elif VARIO_FILTER == VARIO_FILTER_REGRESSION
+		speed.push(altitude, (float)dt / 1000000.0);
+		speed_v = speed.slope();
+#else
+		speed.push( (altitude - altitude_prev) * 1000000.0 / (float)dt );
 	
-	//printf("%d\n", uint32_t(800.0 * pow(2.0, (speed.mean() / 2) ) ) );
+		//printf("%d\n", uint32_t(800.0 * pow(2.0, (speed.mean() / 2) ) ) );
+
+		speed_v = speed.mean();
+#endif
+#endif
+		VARIO_STAGE_END(VARIO_STAGE_FILTER);
+		sampled = true;
+	}
+}
 
-	speed_v = speed.mean();
-	if( (speed_v >= 0.2) && (speed_v <= 8.0) )
+void Vario::updateTone()
+{
+	VARIO_STAGE_START();
+	if( (speed_v >= VARIO_SPEED(0.2)) && (speed_v <= VARIO_SPEED(8.0)) )
 	{
-		uint32_t tone = (450.0 * pow(2.0, (speed_v / 8.0) ) );
+		uint32_t tone = vario_tone(speed_v);
 		pulseToneSet(
 			tone,
 			8 + (900 - tone) / 40,
 			4 + (900 - tone) / 20
 		);
-		if(speed_v < 1.0) toneACsetFrequency(tone);
+		if(speed_v < VARIO_SPEED(1.0)) toneACsetFrequency(tone);
 		pulseToneStart();
 	}
-	else if( (speed_v > 8.0) && (speed_v < 40.0) )
+	else if( (speed_v > VARIO_SPEED(8.0)) && (speed_v < VARIO_SPEED(40.0)) )
 	{
-		uint32_t tone = (450.0 * pow(2.0, (speed_v / 8.0) ) );
+		uint32_t tone = vario_tone(speed_v);
 		pulseToneSet(
 			tone,
 			8,
 			4
 		);
-		if(speed_v < 1.0) toneACsetFrequency(tone);
+		if(speed_v < VARIO_SPEED(1.0)) toneACsetFrequency(tone);
 		pulseToneStart();
 	}
 	else
 	{
 		pulseToneStop();
 	}
+	VARIO_STAGE_END(VARIO_STAGE_TONE);
 }
 
 void Vario::setZeroAltitude()
@@ -74,40 +209,73 @@ void Vario::measureBattery()
 
 static char buffer[8] = {0};
 
-void Vario::drawBase()
+#ifdef VARIO_FIXED_POINT
+// Integer replacement of "%*.*f", value is scaled by 10^decimals
+static void sprint_fixed(char *buffer, int32_t value, uint8_t width, uint8_t decimals)
 {
-	// altitude
-	display->print("m", font_2x7, true, 4, 13, 1, false);
+	uint16_t scale = 1;
+	for(uint8_t d = 0; d < decimals; d++) scale *= 10;
 
-	// speed
-	display->print("m/s", font_1x4, true, 7, 8);
+	uint32_t abs_value = (value < 0) ? -value : value;
+	char number[13];
+	snprintf(number, sizeof(number), "%s%lu.%0*lu", (value < 0) ? "-" : "", abs_value / scale, (int)decimals, abs_value % scale);
+	snprintf(buffer, width + 1, "%*s", (int)width, number);
+}
 
-	// pressure
-	display->print("hPa", font_1x4, false, 0, 36);
+// Q16.16 to integer scaled by mult, rounded
+static int32_t q16_scale(int32_t value, uint8_t mult)
+{
+	return ( (int64_t)value * mult + 32768) >> 16;
+}
+#endif
 
-	// temperature
-	display->print("oC", font_1x4, false, 0, 82);
+void Vario::drawBase(uint8_t pages)
+{
+	if(pages & VARIO_PAGES_MAIN)
+	{
+		// altitude
+		display->print("m", font_2x7, true, 4, 13, 1, false);
 
-	// battery
-	display->print("%", font_1x4, true, 0, 0);
+		// speed
+		display->print("m/s", font_1x4, true, 7, 8);
+	}
 
-	// zero_altitude
-	display->print("m", font_1x4, false, 1, 36);
+	if(pages & VARIO_PAGES_SEC)
+	{
+		// pressure
+		display->print("hPa", font_1x4, false, 0, 36);
 
-	// humidity
-	display->print("%", font_1x4, false, 1, 82);
+		// temperature
+		display->print("oC", font_1x4, false, 0, 82);
+
+		// battery
+		display->print("%", font_1x4, true, 0, 0);
+
+		// zero_altitude
+		display->print("m", font_1x4, false, 1, 36);
+
+		// humidity
+		display->print("%", font_1x4, false, 1, 82);
+	}
 }
 
 void Vario::drawMain()
 {
+	VARIO_STAGE_START();
+
 	// altitude
+#ifdef VARIO_FIXED_POINT
+	sprint_fixed(buffer, q16_scale(altitude - zero_altitude, 10), 6, 1);
+#else
 	sprintf(buffer, "%6.1f", altitude - zero_altitude);
+#endif
 	for(uint8_t c = 0; c < 6; c++)
 	{
 		if(buffer[c] == ' ')buffer[c] = '/';
 	}
 	buffer[6] = 0;
-	display->print(
+	display->printField(
+		VARIO_FIELD_ALTITUDE,
 		buffer,
 		font_digits_4x14,
 		true,
@@ -118,9 +286,14 @@ void Vario::drawMain()
 	);
 
 	//speed
+#ifdef VARIO_FIXED_POINT
+	sprint_fixed(buffer, speed_v, 5, 2);
+#else
 	sprintf(buffer, "%5.2f", speed_v);//speed.mean() );
+#endif
 	buffer[5] = 0;
-	display->print(
+	display->printField(
+		VARIO_FIELD_SPEED,
 		buffer,
 		font_2x7,
 		true,
@@ -129,14 +302,20 @@ void Vario::drawMain()
 		2,
 		false
 	);
+	VARIO_STAGE_END(VARIO_STAGE_DISPLAY);
 }
 
 void Vario::drawSec()
 {
 	// pressure
+#ifdef VARIO_FIXED_POINT
+	sprint_fixed(buffer, (pressure + 128) >> 8, 7, 2);
+#else
 	sprintf(buffer, "%7.2f", pressure / 100);
+#endif
 	buffer[7] = 0;
-	display->print(
+	display->printField(
+		VARIO_FIELD_PRESSURE,
 		buffer,
 		font_1x4,
 		false,
@@ -145,9 +324,15 @@ void Vario::drawSec()
 	);
 
 	// temperature
+#ifdef VARIO_FIXED_POINT
+	// 0.01 degC to 0.1 degC, rounded half away from zero as printf does
+	sprint_fixed(buffer, (temperature + (temperature < 0 ? -5 : 5) ) / 10, 4, 1);
+#else
 	sprintf(buffer, "%4.1f", temperature);
+#endif
 	buffer[4] = 0;
-	display->print(
+	display->printField(
+		VARIO_FIELD_TEMPERATURE,
 		buffer,
 		font_1x4,
 		false,
@@ -156,9 +341,14 @@ void Vario::drawSec()
 	);
 
 	// humidity
+#ifdef VARIO_FIXED_POINT
+	sprint_fixed(buffer, (humidity * 10 + 512) >> 10, 5, 1);
+#else
 	sprintf(buffer, "%5.1f", humidity);
+#endif
 	buffer[5] = 0;
-	display->print(
+	display->printField(
+		VARIO_FIELD_HUMIDITY,
 		buffer,
 		font_1x4,
 		false,
@@ -170,9 +360,14 @@ void Vario::drawSec()
 void Vario::drawZeroAlt()
 {
 	// zero_altitude
+#ifdef VARIO_FIXED_POINT
+	sprint_fixed(buffer, q16_scale(zero_altitude, 10), 7, 1);
+#else
 	sprintf(buffer, "%7.1f", zero_altitude);
+#endif
 	buffer[7] = 0;
-	display->print(
+	display->printField(
+		VARIO_FIELD_ZERO_ALTITUDE,
 		buffer,
 		font_1x4,
 		false,
@@ -185,7 +380,8 @@ void Vario::drawBattery()
 {
 	// battery_level
 	sprintf(buffer, "%d", battery_level);
-	display->print(
+	display->printField(
+		VARIO_FIELD_BATTERY,
 		buffer,
 		font_1x4,
 		true,
@@ -194,56 +390,169 @@ void Vario::drawBattery()
 	);
 }
 
-void Vario::draw()
+void Vario::draw(uint8_t pages)
 {
-	drawBase();
-	drawMain();
-	drawSec();
-	drawZeroAlt();
-	drawBattery();
+	drawBase(pages);
+	if(pages & VARIO_PAGES_MAIN) drawMain();
+	if(pages & VARIO_PAGES_SEC)
+	{
+		drawSec();
+		drawZeroAlt();
+		drawBattery();
+	}
 }
 
 
 void Vario::enter()
 {
-	draw();
+	// Settings edited in menu, restart acquisition with new output rate
+	if(sensor->settingsChanged())
+	{
+		sampler_stop();
+		sensor->startNormalACQ();
+		sampler_start(sensor);
+	}
+
+	// Warm resume, repaint only what was written since last exit
+	exit_request = false;
+	uint8_t pages = display->driver()->clearDamaged();
+	display->invalidateFields(pages);
+	draw(pages);
+	addForegroundTasks();
 	loop();
-	pulseToneStop();
+	removeForegroundTasks();
+	display->driver()->clearDamage();
 }
 
 
-void Vario::loop()
+void Vario::addForegroundTasks()
+{
+	foreground_tasks[0] = scheduler->addTask(_vario_task_buttons, taskButtons, this, VARIO_BUTTONS_PERIOD, 2);
+	foreground_tasks[1] = scheduler->addTask(_vario_task_display, taskDisplay, this, VARIO_DISPLAY_PERIOD, 3);
+	foreground_tasks[2] = scheduler->addTask(_vario_task_display_sec, taskDisplaySec, this, VARIO_DISPLAY_SEC_PERIOD, 4);
+	foreground_tasks[3] = scheduler->addTask(_vario_task_display_battery, taskDisplayBattery, this, VARIO_BATTERY_PERIOD, 4);
+}
+
+void Vario::removeForegroundTasks()
 {
-	BTNstatus btn;
-	uint8_t cycle = 0;
+	for(uint8_t t = 0; t < VARIO_FOREGROUND_TASKS; t++) scheduler->removeTask(foreground_tasks[t]);
+}
 
-	while(true)
+void Vario::taskSensor(void *vario)
+{
+	( (Vario*)vario)->measure();
+}
+
+void Vario::taskAudio(void *vario)
+{
+	( (Vario*)vario)->updateTone();
+}
+
+void Vario::taskButtons(void *vario)
+{
+	( (Vario*)vario)->buttons();
+}
+
+void Vario::taskDisplay(void *vario)
+{
+	( (Vario*)vario)->drawMain();
+}
+
+void Vario::taskDisplaySec(void *vario)
+{
+	( (Vario*)vario)->drawSec();
+}
+
+void Vario::taskBattery(void *vario)
+{
+	( (Vario*)vario)->measureBattery();
+}
+
+void Vario::taskDisplayBattery(void *vario)
+{
+	( (Vario*)vario)->drawBattery();
+}
+
+#ifdef DEBUG
+void Vario::taskStats(void *vario)
+{
+	( (Vario*)vario)->scheduler->printStats();
+	printf("display saved %lu B\n", ( (Vario*)vario)->display->bytesSaved() );
+#ifdef VARIO_STAGE_TIMING
+	( (Vario*)vario)->printStageTimes();
+#endif
+	( (Vario*)vario)->scheduler->resetStats();
+}
+#endif
+
+#ifdef VARIO_STAGE_TIMING
+uint32_t Vario::stageTime(uint8_t stage, uint32_t start)
+{
+	uint32_t now = timer_get_us();
+	uint32_t time = now - start;
+
+	VarioStageTime &stage_t = stage_time[stage];
+	stage_t.total += time;
+	if(time > stage_t.max) stage_t.max = time;
+	stage_t.runs++;
+	return now;
+}
+
+void Vario::printStageTimes()
+{
+	// Per sample stages share one sensor period, tone and display have their own
+	uint32_t sample_cycles = 0;
+
+	printf("stage        runs  avg_cyc  max_cyc\n");
+	for(uint8_t s = 0; s < VARIO_STAGES; s++)
+	{
+		VarioStageTime &stage_t = stage_time[s];
+		uint32_t avg = stage_t.runs ? (stage_t.total * (F_CPU / 1000000) / stage_t.runs) : 0;
+		if(s <= VARIO_STAGE_FILTER) sample_cycles += avg;
+
+		printf(
+			"%-10S %6u %8lu %8lu\n",
+			_vario_stage_names[s],
+			stage_t.runs,
+			avg,
+			stage_t.max * (F_CPU / 1000000)
+		);
+		stage_t.total = 0;
+		stage_t.max = 0;
+		stage_t.runs = 0;
+	}
+	printf(
+		"sample %lu of %lu cycles budget\n",
+		sample_cycles,
+		(uint32_t)VARIO_SENSOR_PERIOD * (F_CPU / 1000000)
+	);
+}
+#endif
+
+
+void Vario::buttons()
+{
+	BTNstatus btn = delay_btn_read();
+
+	if(btn.btn_ac) 
+	{
+		exit_request = true;
+	}
+	else if(btn.btn_b) 
+	{
+		setZeroAltitude();
+	}
+	else if(btn.btn_a) 
 	{
-		measure();
-
-		btn = delay_btn_read();
-
-		if(btn.btn_ac) 
-		{
-			break;
-		}
-		else if(btn.btn_b) 
-		{
-			setZeroAltitude();
-		}
-		else if(btn.btn_a) 
-		{
-			speed_v += 0.05;
-		}
-		else if(btn.btn_c) 
-		{
-			speed_v -= 0.05;
-		}
-		
-		drawMain();
-		if((cycle % 32) == 0) drawSec();
-
-		cycle++;
-		//_delay_ms(100);
+		speed_v += VARIO_SPEED(0.05);
 	}
+	else if(btn.btn_c) 
+	{
+		speed_v -= VARIO_SPEED(0.05);
+	}
+}
+
+void Vario::loop()
+{
+	while(!exit_request) scheduler->runOnce();
 }
\ No newline at end of file
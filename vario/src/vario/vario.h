@@ -5,48 +5,182 @@
 
 #include "../utils/display/display.h"
 #include "../utils/data_filter/data_filter.h"
+#include "../utils/data_filter/kalman_filter.h"
+#include "../utils/data_filter/regression_filter.h"
 #include "../hardware/bme280/bme280.h"
 #include "../hardware/toneAC/toneAC.h"
 #include "../hardware/battery/battery.h"
 #include "../hardware/buttons/buttons.h"
+#include "../utils/scheduler/scheduler.h"
+#include "sampler.h"
+
+// Vertical speed estimator
+#define VARIO_FILTER_MEAN                  0
+#define VARIO_FILTER_KALMAN                1
+#define VARIO_FILTER_REGRESSION            2
+
+#ifndef VARIO_FILTER
+#define VARIO_FILTER                       VARIO_FILTER_KALMAN
+#endif
+
+// Fixed-point chain (FIXED_POINT=1 in make_variables.mk):
+//   altitude in m * 65536 (Q16.16), vertical speed in cm/s
+//   mean filter only, make_variables.mk selects it with FIXED_POINT=1
+#ifdef VARIO_FIXED_POINT
+#if VARIO_FILTER != VARIO_FILTER_MEAN
+#error "VARIO_FIXED_POINT has no fixed-point Kalman or regression filter, build with VARIO_FILTER=VARIO_FILTER_MEAN"
+#endif
+typedef int32_t vario_altitude_t;
+typedef int32_t vario_speed_t;
+#define VARIO_SPEED(speed)                 ( (vario_speed_t)( (speed) * 100) )
+#else
+typedef float vario_altitude_t;
+typedef float vario_speed_t;
+#define VARIO_SPEED(speed)                 (speed)
+#endif
+
+#define VARIO_TONE_BASE                    450
+
+// Task periods in us
+#define VARIO_SENSOR_PERIOD                5000
+#define VARIO_AUDIO_PERIOD                 20000
+#define VARIO_BUTTONS_PERIOD               20000
+#define VARIO_DISPLAY_PERIOD               100000
+#define VARIO_DISPLAY_SEC_PERIOD           1000000
+#define VARIO_BATTERY_PERIOD               10000000
+#define VARIO_STATS_PERIOD                 10000000
+
+// Display pages of screen parts
+#define VARIO_PAGES_SEC                    0x03 // pressure, temperature, humidity, zero altitude, battery
+#define VARIO_PAGES_MAIN                   0xFC // altitude, speed
+#define VARIO_PAGES_ALL                    0xFF
+
+// Display::printField() cache slots
+#define VARIO_FIELD_ALTITUDE               0
+#define VARIO_FIELD_SPEED                  1
+#define VARIO_FIELD_PRESSURE               2
+#define VARIO_FIELD_TEMPERATURE            3
+#define VARIO_FIELD_HUMIDITY               4
+#define VARIO_FIELD_ZERO_ALTITUDE          5
+#define VARIO_FIELD_BATTERY                6
+
+// Display and button tasks, registered only while vario screen is shown
+#define VARIO_FOREGROUND_TASKS             4
+
+// Uncomment to add cycles per stage of measurement chain to DEBUG stats,
+// budget is VARIO_SENSOR_PERIOD for everything done per sensor sample
+//#define VARIO_STAGE_TIMING
+
+#ifdef VARIO_STAGE_TIMING
+#define VARIO_STAGE_COMPENSATE             0 // decode + BME280 compensation
+#define VARIO_STAGE_ALTITUDE               1 // pressure to altitude
+#define VARIO_STAGE_FILTER                 2 // vertical speed filter
+#define VARIO_STAGE_TONE                   3 // updateTone()
+#define VARIO_STAGE_DISPLAY                4 // drawMain(), formatting + I2C
+#define VARIO_STAGES                       5
+
+struct VarioStageTime
+{
+	uint32_t total; // us
+	uint32_t max;   // us
+	uint16_t runs;
+};
+
+#define VARIO_STAGE_START()                uint32_t _stage_start = timer_get_us()
+#define VARIO_STAGE_END(stage)             _stage_start = stageTime(stage, _stage_start)
+#else
+#define VARIO_STAGE_START()
+#define VARIO_STAGE_END(stage)
+#endif
 
 class Vario
 {
 	BME280 *sensor;
 	Display *display;
+	Scheduler *scheduler;
+
+	bool exit_request = false;
+	int8_t foreground_tasks[VARIO_FOREGROUND_TASKS];
 
 
+#ifdef VARIO_FIXED_POINT
+	// Pa * 256, 0.01 degC, %RH * 1024
+	uint32_t pressure = 0;
+	int32_t temperature = 0;
+	uint32_t humidity = 0;
+#else
 	float pressure = 0;
 	float temperature = 0;
 	float humidity = 0;
+#endif
+
+	vario_altitude_t altitude = 0;
+	vario_altitude_t altitude_prev = 0;
+
+	// us, conversion timestamp of last sample from sampler
+	uint32_t sample_time = 0;
+	bool sampled = false;
+
+	vario_altitude_t zero_altitude = 0;
+#ifdef VARIO_FIXED_POINT
+	DataFilter<int32_t, DATA_BUFFER_SIZE, int64_t> speed;
+#elif VARIO_FILTER == VARIO_FILTER_KALMAN
+	KalmanFilter speed;
+#elif VARIO_FILTER == VARIO_FILTER_REGRESSION
+	RegressionFilter<> speed;
+#else
+	DataFilter<float> speed;
+#endif
 
-	float altitude = 0;
-	float altitude_prev = 0;
+	uint16_t battery_level = 0;
 
-	float zero_altitude = 0;
-	DataFilter speed;
+	vario_speed_t speed_v = 0;
 
-	uint16_t battery_level = 0;
+#ifdef VARIO_STAGE_TIMING
+	VarioStageTime stage_time[VARIO_STAGES] = {};
 
-	float speed_v = 0;
+	// Adds time since start to stage, returns now
+	uint32_t stageTime(uint8_t stage, uint32_t start);
+	void printStageTimes();
+#endif
 
 	void measure();
+	void updateTone();
 	void measureBattery();
 
-	void drawBase();
+	void drawBase(uint8_t pages);
 	void drawMain();
 	void drawSec();
 	void drawZeroAlt();
 	void drawBattery();
-	void draw();
+	// pages: bit per display page to repaint
+	void draw(uint8_t pages = VARIO_PAGES_ALL);
 
 	void setZeroAltitude();
+	void buttons();
 
+	void addForegroundTasks();
+	void removeForegroundTasks();
 	void loop();
 
+	static void taskSensor(void *vario);
+	static void taskAudio(void *vario);
+	static void taskButtons(void *vario);
+	static void taskDisplay(void *vario);
+	static void taskDisplaySec(void *vario);
+	static void taskBattery(void *vario);
+	static void taskDisplayBattery(void *vario);
+#ifdef DEBUG
+	static void taskStats(void *vario);
+#endif
+
 public:
-	Vario(BME280 *sensor, Display *display);
+	// Starts sampling, filter and audio as background tasks
+	Vario(BME280 *sensor, Display *display, Scheduler *scheduler);
+	~Vario();
 
+	// Vario screen until A+C, background tasks keep running after return.
+	// Screen is not cleared, only areas written by others meanwhile are repainted
 	void enter();
 };
 
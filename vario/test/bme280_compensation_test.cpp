@@ -0,0 +1,177 @@
+// Integer BME280 compensation against Bosch double precision formulas
+// (datasheet 8.1) over a table of raw readings, with the datasheet
+// calibration set. Built once per pressure formula, see Makefile.
+// Also checks that forced and normal ACQ timing agree on measurement time.
+
+#include <stdio.h>
+#include <math.h>
+
+#include "hardware/bme280/bme280.h"
+
+// Max deviation from double precision reference
+#define TOLERANCE_TEMPERATURE   0.015 // degC, t_fine truncation + output rounding
+#ifdef BME280_PRESSURE_32BIT
+#define TOLERANCE_PRESSURE      4.0   // Pa, formula resolves 1 Pa, ~35 cm
+#else
+#define TOLERANCE_PRESSURE      0.03  // Pa, ~0.3 cm
+#endif
+#define TOLERANCE_HUMIDITY      0.01  // %RH
+
+// BMP280 datasheet 3.12 example, temperature and pressure part
+// of BME280 is the same. Datasheet gives no humidity example,
+// humidity coefficients are typical values read from a sensor.
+const BME280CalibData _calib_data = {
+	27504, 26435, -1000, 0,
+	36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000,
+	75, 370, 0, 309, 50, 30
+};
+
+struct RawSample
+{
+	uint32_t temperature;
+	uint32_t pressure;
+	uint32_t humidity;
+};
+
+// Datasheet example first, then about 0..50 degC and 24000..114000 Pa
+const RawSample _raw_samples[] = {
+	{ 519888, 415148, 30000 },
+	{ 440000, 860000, 20000 },
+	{ 470000, 760000, 26000 },
+	{ 495000, 660000, 32000 },
+	{ 510000, 560000, 36000 },
+	{ 530000, 460000, 40000 },
+	{ 550000, 400000, 28000 },
+	{ 575000, 356000, 24000 },
+	{ 600000, 380000, 22000 }
+};
+
+// Datasheet example result
+#define EXAMPLE_TEMPERATURE     2508      // 0.01 degC
+#define EXAMPLE_PRESSURE        100653.27 // Pa
+
+// Datasheet 9.1 measurement time with all oversampling x1, in ms
+#define EXAMPLE_ACQ_DELAY       8         // 1 + 3 * 2 + 2 * 0.5
+#define EXAMPLE_ACQ_MAX_DELAY   9         // 1.25 + 3 * 2.3 + 2 * 0.575 = 9.3
+
+// Normal ACQ standby with t_sb 0, in us
+#define STANDBY_0_US            500
+
+// Access to calibration of a sensor that is not connected
+class BME280Test : public BME280
+{
+public:
+	void setCalibData(const BME280CalibData &calib) { calib_data = calib; }
+};
+
+struct Reference
+{
+	double temperature;
+	double pressure;
+	double humidity;
+};
+
+static Reference reference(const BME280CalibData &c, const RawSample &raw)
+{
+	Reference r;
+
+	double var1 = (raw.temperature / 16384.0 - c.dig_t1 / 1024.0) * c.dig_t2;
+	double var2 = (raw.temperature / 131072.0 - c.dig_t1 / 8192.0);
+	var2 = var2 * var2 * c.dig_t3;
+	double t_fine = var1 + var2;
+	r.temperature = t_fine / 5120.0;
+
+	var1 = t_fine / 2.0 - 64000.0;
+	var2 = var1 * var1 * c.dig_p6 / 32768.0;
+	var2 = var2 + var1 * c.dig_p5 * 2.0;
+	var2 = var2 / 4.0 + c.dig_p4 * 65536.0;
+	var1 = (c.dig_p3 * var1 * var1 / 524288.0 + c.dig_p2 * var1) / 524288.0;
+	var1 = (1.0 + var1 / 32768.0) * c.dig_p1;
+	double p = 1048576.0 - raw.pressure;
+	p = (p - var2 / 4096.0) * 6250.0 / var1;
+	var1 = c.dig_p9 * p * p / 2147483648.0;
+	var2 = p * c.dig_p8 / 32768.0;
+	r.pressure = p + (var1 + var2 + c.dig_p7) / 16.0;
+
+	double h = t_fine - 76800.0;
+	h = (raw.humidity - (c.dig_h4 * 64.0 + c.dig_h5 / 16384.0 * h)) *
+		(c.dig_h2 / 65536.0 * (1.0 + c.dig_h6 / 67108864.0 * h * (1.0 + c.dig_h3 / 67108864.0 * h)));
+	h = h * (1.0 - c.dig_h1 * h / 524288.0);
+	r.humidity = (h < 0) ? 0 : ( (h > 100) ? 100 : h);
+
+	return r;
+}
+
+static uint16_t failures = 0;
+
+static void check(const char *name, uint8_t row, double value, double expected, double tolerance)
+{
+	double error = fabs(value - expected);
+	bool ok = error <= tolerance;
+	if(!ok) failures++;
+
+	printf("%s row %u %-12s %12.4f ref %12.4f err %.4f\n", ok ? "  ok" : "FAIL", row, name, value, expected, error);
+}
+
+int main()
+{
+	BME280Test sensor;
+	sensor.setCalibData(_calib_data);
+
+#ifdef BME280_PRESSURE_32BIT
+	printf("BME280 compensation, 32-bit pressure formula\n");
+#else
+	printf("BME280 compensation, 64-bit pressure formula\n");
+#endif
+
+	const uint8_t rows = sizeof(_raw_samples) / sizeof(_raw_samples[0]);
+	for(uint8_t row = 0; row < rows; row++)
+	{
+		RawSample raw = _raw_samples[row];
+		Reference ref = reference(_calib_data, raw);
+
+		// Integer path, temperature first to set t_fine
+		int32_t temperature = sensor.compensateTemperatureInt(raw.temperature);
+		uint32_t pressure = sensor.compensatePressureInt(raw.pressure);
+		uint32_t humidity = sensor.compensateHumidityInt(raw.humidity);
+
+		check("temperature", row, temperature / 100.0, ref.temperature, TOLERANCE_TEMPERATURE);
+		check("pressure", row, pressure / 256.0, ref.pressure, TOLERANCE_PRESSURE);
+		check("humidity", row, humidity / 1024.0, ref.humidity, TOLERANCE_HUMIDITY);
+
+		// Float path is a conversion of the integer one, must agree exactly
+		check("temp float", row, sensor.compensateTemperature(raw.temperature), temperature / 100.0f, 0);
+		check("press float", row, sensor.compensatePressure(raw.pressure), (float)(pressure / 256.0), 0);
+		check("hum float", row, sensor.compensateHumidity(raw.humidity), humidity / 1024.0f, 0);
+
+		if(row == 0)
+		{
+			check("example T", row, temperature, EXAMPLE_TEMPERATURE, 0);
+			check("example P", row, pressure / 256.0, EXAMPLE_PRESSURE, TOLERANCE_PRESSURE);
+		}
+	}
+
+	// Sample period less standby is the forced ACQ delay before truncation to ms
+	BME280Settings settings;
+	uint16_t mismatches = 0;
+	for(uint16_t osrs = 0; osrs < 8 * 8 * 8; osrs++)
+	{
+		settings.ctrl_meas.osrs_t = osrs & 7;
+		settings.ctrl_meas.osrs_p = (osrs >> 3) & 7;
+		settings.ctrl_hum.osrs_h = osrs >> 6;
+
+		uint32_t measurement = BME280samplePeriod(settings) - STANDBY_0_US;
+		uint32_t delay = BME280ACQdelay(settings);
+		if( (measurement / BME280_MEAS_SCALING_FACTOR != delay) || (BME280ACQmaxDelay(settings) < delay) ) mismatches++;
+	}
+	check("ACQ timing", 0, mismatches, 0, 0);
+
+	settings.ctrl_meas.osrs_t = BME280driver::SAMPLING_X1;
+	settings.ctrl_meas.osrs_p = BME280driver::SAMPLING_X1;
+	settings.ctrl_hum.osrs_h = BME280driver::SAMPLING_X1;
+	check("example ACQ", 0, BME280ACQdelay(settings), EXAMPLE_ACQ_DELAY, 0);
+	check("example max", 0, BME280ACQmaxDelay(settings), EXAMPLE_ACQ_MAX_DELAY, 0);
+
+	printf("%u failures\n", failures);
+	return failures ? 1 : 0;
+}
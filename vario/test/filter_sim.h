@@ -0,0 +1,108 @@
+#ifndef FILTER_SIM_H
+#define FILTER_SIM_H
+
+// Simulated climb for host tests of vertical speed estimators
+
+#include <stdint.h>
+#include <math.h>
+
+#include "utils/data_filter/data_filter.h"
+
+// Simulated flight: level, then climb at STEP_SPEED from sample STEP_AT
+#define SAMPLE_DT        0.02  // s, nominal, every sample jitters +-10 %
+#define ALTITUDE_NOISE   0.2   // m RMS, ~BME280 x16 oversampling without IIR
+#define STEP_SPEED       2.0   // m/s
+#define STEP_AT          300
+#define SAMPLES          600
+// Stationary noise is measured after filters settled from start
+#define NOISE_FROM       100
+#define RUNS             200
+
+struct StepResponse
+{
+	double noise;   // m/s RMS of speed before step
+	double latency; // s until mean response over runs reaches 90 % of step
+};
+
+// Small LCG, same noise sequence for every filter
+static uint32_t seed;
+
+static double uniform()
+{
+	seed = seed * 1664525 + 1013904223;
+	return ( (seed >> 8) + 0.5) / 16777216.0;
+}
+
+static double gauss()
+{
+	return sqrt(-2 * log(uniform() ) ) * cos(2 * M_PI * uniform() );
+}
+
+// Filter wraps one estimator: reset(), then speed = update(altitude, dt)
+template <class Filter>
+static StepResponse step_response(Filter &filter)
+{
+	static double response[SAMPLES];
+	for(uint16_t i = 0; i < SAMPLES; i++) response[i] = 0;
+	double noise_sum = 0;
+	uint32_t noise_count = 0;
+
+	for(uint16_t run = 0; run < RUNS; run++)
+	{
+		seed = run * 7919 + 1;
+		filter.reset();
+
+		double altitude = 0;
+		for(uint16_t i = 0; i < SAMPLES; i++)
+		{
+			double dt = SAMPLE_DT * (0.9 + 0.2 * uniform() );
+			if(i >= STEP_AT) altitude += STEP_SPEED * dt;
+
+			double speed = filter.update(altitude + ALTITUDE_NOISE * gauss(), dt);
+
+			response[i] += speed / RUNS;
+			if( (i >= NOISE_FROM) && (i < STEP_AT) )
+			{
+				noise_sum += speed * speed;
+				noise_count++;
+			}
+		}
+	}
+
+	StepResponse result = { sqrt(noise_sum / noise_count), -1 };
+	for(uint16_t i = STEP_AT; i < SAMPLES; i++)
+	{
+		if(response[i] >= 0.9 * STEP_SPEED)
+		{
+			result.latency = (i - STEP_AT + 1) * SAMPLE_DT;
+			break;
+		}
+	}
+	return result;
+}
+
+// Vario::measure() mean of finite differences
+struct MeanOfDifferences
+{
+	DataFilter<float> speed;
+	float altitude_prev;
+	bool sampled;
+
+	void reset()
+	{
+		speed.reset();
+		sampled = false;
+	}
+
+	float update(float altitude, float dt)
+	{
+		if(!sampled) altitude_prev = altitude;
+		sampled = true;
+
+		speed.push( (altitude - altitude_prev) / dt);
+		altitude_prev = altitude;
+		return speed.mean();
+	}
+};
+
+#endif // FILTER_SIM_H
@@ -0,0 +1,74 @@
+// Vertical speed step response of KalmanFilter vs the 14 sample mean of
+// finite differences (DataFilter), at equal output noise. Kalman process
+// noise is searched until its stationary speed noise matches the mean's,
+// then its latency must be lower. The shipped default noise values must
+// give the same noise within KALMAN_MAX_LATENCY.
+
+#include <stdio.h>
+#include <math.h>
+
+#include "utils/data_filter/kalman_filter.h"
+#include "filter_sim.h"
+
+// Relative noise match of Kalman vs mean
+#define NOISE_MATCH      0.02
+// Latency bound of the shipped defaults, s
+#define KALMAN_MAX_LATENCY 0.18
+
+struct Kalman
+{
+	KalmanFilter speed;
+
+	Kalman(float process_noise, float measurement_noise = ALTITUDE_NOISE * ALTITUDE_NOISE) : speed(process_noise, measurement_noise) {}
+
+	void reset()
+	{
+		speed = KalmanFilter(speed.getProcessNoise(), speed.getMeasurementNoise() );
+	}
+
+	float update(float altitude, float dt)
+	{
+		speed.update(altitude, dt);
+		return speed.speed();
+	}
+};
+
+int main()
+{
+	MeanOfDifferences mean;
+	StepResponse mean_response = step_response(mean);
+	printf("mean of %u differences: noise %.3f m/s, latency %.2f s\n", DATA_BUFFER_SIZE, mean_response.noise, mean_response.latency);
+
+	// Speed noise grows monotonically with process noise, bisect in log scale
+	double q_low = 1e-2, q_high = 1e6;
+	StepResponse kalman_response = { 0, 0 };
+	double q = 0;
+	for(uint8_t i = 0; i < 60; i++)
+	{
+		q = sqrt(q_low * q_high);
+		Kalman kalman(q);
+		kalman_response = step_response(kalman);
+
+		if(fabs(kalman_response.noise / mean_response.noise - 1) < NOISE_MATCH) break;
+		if(kalman_response.noise < mean_response.noise) q_low = q;
+		else q_high = q;
+	}
+	printf("kalman q %.1f: noise %.3f m/s, latency %.2f s\n", q, kalman_response.noise, kalman_response.latency);
+
+	bool ok = (fabs(kalman_response.noise / mean_response.noise - 1) < NOISE_MATCH) &&
+		(kalman_response.latency > 0) &&
+		(kalman_response.latency < mean_response.latency);
+	printf("%s\n", ok ? "ok" : "FAIL: kalman is not faster at equal noise");
+
+	Kalman shipped(KALMAN_DEFAULT_PROCESS_NOISE, KALMAN_DEFAULT_MEASUREMENT_NOISE);
+	StepResponse shipped_response = step_response(shipped);
+	printf("kalman default q %.1f R %.2f: noise %.3f m/s, latency %.2f s\n",
+		KALMAN_DEFAULT_PROCESS_NOISE, KALMAN_DEFAULT_MEASUREMENT_NOISE, shipped_response.noise, shipped_response.latency);
+
+	bool shipped_ok = (fabs(shipped_response.noise / mean_response.noise - 1) < NOISE_MATCH) &&
+		(shipped_response.latency > 0) &&
+		(shipped_response.latency <= KALMAN_MAX_LATENCY);
+	printf("%s\n", shipped_ok ? "ok" : "FAIL: kalman defaults are not tuned to mean noise and latency bound");
+
+	return (ok && shipped_ok) ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+// Pages damaged by a menu list opened over the vario screen. A list
+// shorter than the screen must damage only the pages of its rows, so
+// Vario::enter() redraws only those, also after moving the selection.
+// A list of four and more rows covers the screen.
+
+#include <stdio.h>
+
+#include "menu/menu.h"
+#include "utils/time_clock/time_clock.h"
+
+static uint32_t now = 0;
+
+void time_clock_init() {}
+uint32_t timer_get_us() { return now += 100; }
+uint32_t timer_get() { return now / 1000; }
+
+void led_enable() {}
+void led_disable() {}
+
+void Scheduler::runOnce() {}
+
+// Buttons pressed by successive menu reads, then exit (A + C)
+static const uint8_t *button_script = 0;
+static uint8_t buttons_left = 0;
+
+BTNstatus debounce_btn_read() { return BTNstatus { .raw = 0 }; }
+
+BTNstatus delay_btn_read()
+{
+	BTNstatus btn { .raw = 0 };
+	if(buttons_left)
+	{
+		btn.raw = *button_script++;
+		buttons_left--;
+	}
+	else btn.btn_ac = 1;
+	return btn;
+}
+
+static uint16_t failures = 0;
+
+static void check(const char *name, uint8_t pages, uint8_t expected)
+{
+	bool ok = (pages == expected);
+	if(!ok) failures++;
+	printf("%s %-26s damaged pages 0x%02X, expected 0x%02X\n", ok ? "  ok" : "FAIL", name, pages, expected);
+}
+
+static const PROGMEM char entry_text[] = {"Entry"};
+
+int main()
+{
+	SSD1306driver driver;
+	Display display(&driver);
+	menu_init(nullptr, &display, nullptr, nullptr);
+
+	MenuListItem entry(entry_text);
+	MenuListItem *entries[] = { &menu_entry_back, &entry, &entry, &entry, &entry };
+
+	// Vario clears its damage when leaving
+	driver.clearDamage();
+	MenuList small(entry_text, entries, 2, 0);
+	small.enter();
+	check("2 rows, opened and closed", driver.damagedPages(), 0x0F);
+	check("vario redraw of 2 rows", driver.clearDamaged(), 0x0F);
+
+	BTNstatus down { .raw = 0 };
+	down.btn_c = 1;
+	const uint8_t moves[] = { down.raw, down.raw, down.raw };
+	button_script = moves;
+	buttons_left = sizeof(moves);
+	MenuList three(entry_text, entries, 3, 0);
+	three.enter();
+	check("3 rows, selection wrapped", driver.clearDamaged(), 0x3F);
+
+	MenuList full(entry_text, entries, 5, 0);
+	full.enter();
+	check("5 rows", driver.clearDamaged(), 0xFF);
+
+	printf("%u failures\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,100 @@
+// Least squares slope (RegressionFilter) vs the mean of finite differences
+// (DataFilter) on the simulated climb of filter_sim.h: speed noise and
+// latency per regression window, and host time per sample. Regression
+// over the same 14 samples must be less noisy, and some window must beat
+// the mean on noise and latency at once.
+
+#include <stdio.h>
+#include <math.h>
+#include <chrono>
+
+#include "utils/data_filter/regression_filter.h"
+#include "filter_sim.h"
+
+// Samples per cost measurement
+#define COST_SAMPLES     1000000
+
+template <uint8_t SIZE>
+struct Regression
+{
+	RegressionFilter<SIZE> speed;
+
+	void reset()
+	{
+		speed.reset();
+	}
+
+	float update(float altitude, float dt)
+	{
+		speed.push(altitude, dt);
+		return speed.slope();
+	}
+};
+
+// ns per update() on the same jittered noisy samples
+template <class Filter>
+static double cost(Filter &filter)
+{
+	static float altitude[SAMPLES];
+	static float dt[SAMPLES];
+	seed = 1;
+	for(uint16_t i = 0; i < SAMPLES; i++)
+	{
+		dt[i] = SAMPLE_DT * (0.9 + 0.2 * uniform() );
+		altitude[i] = ALTITUDE_NOISE * gauss();
+	}
+
+	filter.reset();
+	volatile float sink = 0;
+	auto start = std::chrono::steady_clock::now();
+	for(uint32_t i = 0; i < COST_SAMPLES; i++) sink = filter.update(altitude[i % SAMPLES], dt[i % SAMPLES]);
+	auto time = std::chrono::steady_clock::now() - start;
+	(void)sink;
+
+	return std::chrono::duration<double, std::nano>(time).count() / COST_SAMPLES;
+}
+
+static uint16_t better_windows = 0;
+
+template <uint8_t SIZE>
+static StepResponse report(const StepResponse &mean_response)
+{
+	Regression<SIZE> regression;
+	StepResponse response = step_response(regression);
+
+	bool better = (response.noise < mean_response.noise) && (response.latency < mean_response.latency);
+	if(better) better_windows++;
+
+	printf(
+		"regression %2u: noise %.3f m/s, latency %.2f s, %.0f ns/sample%s\n",
+		SIZE,
+		response.noise,
+		response.latency,
+		cost(regression),
+		better ? " (better on both)" : ""
+	);
+	return response;
+}
+
+int main()
+{
+	MeanOfDifferences mean;
+	StepResponse mean_response = step_response(mean);
+	printf(
+		"mean %2u:       noise %.3f m/s, latency %.2f s, %.0f ns/sample\n",
+		DATA_BUFFER_SIZE,
+		mean_response.noise,
+		mean_response.latency,
+		cost(mean)
+	);
+
+	report<6>(mean_response);
+	report<8>(mean_response);
+	report<10>(mean_response);
+	report<12>(mean_response);
+	StepResponse regression_response = report<DATA_BUFFER_SIZE>(mean_response);
+
+	bool ok = (regression_response.noise < mean_response.noise) && better_windows;
+	printf("%s\n", ok ? "ok" : "FAIL: regression does not improve on mean of differences");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,252 @@
+// Phase lock of the sampler against a simulated BME280 in normal mode,
+// on an idle bus and on a bus shared with blocking display transfers of
+// 10..17 ms every 100 ms. Conversion timestamps of popped samples must
+// keep a constant offset to the true end of conversion, no conversion may
+// be missed and the lock must hold.
+
+#include <stdio.h>
+
+#include "vario/sampler.h"
+#include "hardware/i2cmaster/i2cmaster.h"
+#include "utils/time_clock/time_clock.h"
+
+// Sensor runs this much slower than typical datasheet timing
+#define SENSOR_PERIOD_SCALE   1.03
+#define SENSOR_PHASE          7000    // us, first end of conversion
+
+// Burst of 1 + 12 bytes at 200 kHz, status is read this long after start
+#define BURST_US              700
+#define BURST_STATUS_US       150
+
+#define DISPLAY_PERIOD        100000  // us
+#define DISPLAY_MIN_US        10000
+#define DISPLAY_MAX_US        17000
+
+#define SIM_US                60000000
+// Sampler searches phase and period until then, not checked
+#define SETTLE_US             10000000
+// Consumer drains the buffer at vario sensor task rate
+#define CONSUMER_PERIOD       5000
+
+// Max deviation of timestamp offset from its mean, us, half of the
+// resync distance: no sample was put on a wrong edge
+#define MAX_JITTER            (SAMPLER_RESYNC / 2)
+// Max relative error of period estimate
+#define MAX_PERIOD_ERROR      0.002
+
+
+static uint32_t now = 0;
+static void (*tick_callback)(void) = nullptr;
+
+void time_clock_init() {}
+uint32_t timer_get_us() { return now; }
+uint32_t timer_get() { return now / 1000; }
+void timer_tick_attach(void (*callback)(void)) { tick_callback = callback; }
+
+
+// Sensor: conversion k ends at SENSOR_PHASE + k * period
+static double sensor_period;
+static double sensor_measurement;
+
+static double sensor_edge(int32_t k)
+{
+	return SENSOR_PHASE + k * sensor_period;
+}
+
+static void sensor_read(uint32_t time, uint8_t *reg_data)
+{
+	double since = time - (double)SENSOR_PHASE;
+	int32_t k = (since < 0) ? -1 : (int32_t)(since / sensor_period);
+	double to_edge = sensor_edge(k + 1) - time;
+
+	BME280_reg_status status { .raw = 0 };
+	status.measuring = (to_edge < sensor_measurement);
+	reg_data[0] = status.raw;
+
+	// Data registers hold the number of the last finished conversion
+	for(uint8_t i = BME280_STATUS_DATA_OFFSET; i < BME280_STATUS_DATA_LEN; i++) reg_data[i] = 0;
+	for(uint8_t i = 0; i < 4; i++) reg_data[BME280_STATUS_DATA_OFFSET + i] = (uint32_t)k >> (8 * i);
+}
+
+static int32_t sample_conversion(const SamplerSample &sample)
+{
+	uint32_t k = 0;
+	for(uint8_t i = 0; i < 4; i++) k |= (uint32_t)sample.reg_data[BME280_STATUS_DATA_OFFSET + i] << (8 * i);
+	return (int32_t)k;
+}
+
+
+// Bus: one queued burst, delayed by display transfers holding the bus
+static bool display_load = false;
+static uint32_t display_start = 0;
+static uint32_t display_end = 0;
+static i2c_transaction *burst = nullptr;
+static uint32_t burst_done = 0;
+
+static uint32_t seed = 1;
+
+static uint32_t random_us(uint32_t min, uint32_t max)
+{
+	seed = seed * 1664525 + 1013904223;
+	return min + (seed >> 8) % (max - min + 1);
+}
+
+static void display_update()
+{
+	if(!display_load || (now < display_end) ) return;
+
+	display_start = (now / DISPLAY_PERIOD + 1) * DISPLAY_PERIOD;
+	display_end = display_start + random_us(DISPLAY_MIN_US, DISPLAY_MAX_US);
+}
+
+extern "C"
+{
+void i2c_init(void) {}
+void i2c_stop(void) {}
+unsigned char i2c_start(unsigned char addr) { return I2C_ERR; }
+unsigned char i2c_rep_start(unsigned char addr) { return I2C_ERR; }
+unsigned char i2c_write(unsigned char data) { return I2C_ERR; }
+unsigned char i2c_readAck(void) { return 0; }
+unsigned char i2c_readNak(void) { return 0; }
+
+unsigned char i2c_submit(i2c_transaction *t)
+{
+	if(burst) return I2C_ERR;
+
+	uint32_t start = now;
+	if(display_load && (start >= display_start) && (start < display_end) ) start = display_end;
+
+	t->status = I2C_BUSY;
+	burst = t;
+	burst_done = start + BURST_US;
+	return I2C_OK;
+}
+}
+
+static void burst_finish()
+{
+	i2c_transaction *t = burst;
+	burst = nullptr;
+
+	now = burst_done;
+	sensor_read(burst_done - BURST_US + BURST_STATUS_US, t->rx_data);
+	t->status = I2C_OK;
+	if(t->callback) t->callback(t);
+}
+
+
+struct LockResult
+{
+	double offset;   // us, mean timestamp minus true end of conversion
+	double jitter;   // us, max deviation from mean offset
+	double period_error;
+	uint32_t samples;
+	uint32_t missed;
+	uint32_t unlocked;
+};
+
+static LockResult run(BME280 &sensor, bool load)
+{
+	display_load = load;
+	display_end = 0;
+
+	uint32_t start = now;
+	sampler_start(&sensor);
+
+	LockResult result = { 0, 0, 0, 0, 0, 0 };
+	static double offsets[SIM_US / 1000];
+	int32_t last_k = -1;
+	uint32_t next_tick = (now / TIMER_US_PER_OVERFLOW + 1) * TIMER_US_PER_OVERFLOW;
+	uint32_t next_consume = now + CONSUMER_PERIOD;
+
+	while(now - start < SIM_US)
+	{
+		display_update();
+
+		// Next event: burst completion, timer overflow or consumer
+		uint32_t next = (next_tick < next_consume) ? next_tick : next_consume;
+		if(burst && (burst_done <= next) )
+		{
+			burst_finish();
+			continue;
+		}
+		now = next;
+
+		if(now == next_tick)
+		{
+			next_tick += TIMER_US_PER_OVERFLOW;
+			if(tick_callback) tick_callback();
+		}
+		if(now == next_consume)
+		{
+			next_consume += CONSUMER_PERIOD;
+
+			SamplerSample sample;
+			while(sampler_pop(&sample) )
+			{
+				int32_t k = sample_conversion(sample);
+				bool settled = (now - start > SETTLE_US);
+				if(settled && (last_k >= 0) && (k > last_k + 1) ) result.missed += k - last_k - 1;
+				last_k = k;
+				if(!settled) continue;
+
+				if(!sampler_locked() ) result.unlocked++;
+				offsets[result.samples++] = (int32_t)(sample.time - (uint32_t)sensor_edge(k) );
+			}
+		}
+	}
+
+	for(uint32_t i = 0; i < result.samples; i++) result.offset += offsets[i] / result.samples;
+	for(uint32_t i = 0; i < result.samples; i++)
+	{
+		double deviation = offsets[i] - result.offset;
+		if(deviation < 0) deviation = -deviation;
+		if(deviation > result.jitter) result.jitter = deviation;
+	}
+	result.period_error = sampler_period() / sensor_period - 1;
+
+	sampler_stop();
+	return result;
+}
+
+static uint16_t failures = 0;
+
+static void report(const char *name, const LockResult &r)
+{
+	bool ok = (r.samples > 0) && !r.missed && !r.unlocked && (r.jitter <= MAX_JITTER) &&
+		(r.period_error < MAX_PERIOD_ERROR) && (r.period_error > -MAX_PERIOD_ERROR);
+	if(!ok) failures++;
+
+	printf(
+		"%s %-13s %lu samples, %lu missed, %lu unlocked, offset %.0f us, jitter %.0f us, period error %.3f %%\n",
+		ok ? "  ok" : "FAIL",
+		name,
+		(unsigned long)r.samples,
+		(unsigned long)r.missed,
+		(unsigned long)r.unlocked,
+		r.offset,
+		r.jitter,
+		r.period_error * 100
+	);
+}
+
+int main()
+{
+	BME280 sensor;
+	BME280Settings settings;
+	settings.ctrl_meas.osrs_t = BME280driver::SAMPLING_X1;
+	settings.ctrl_meas.osrs_p = BME280driver::SAMPLING_X8;
+	settings.config.t_sb = BME280driver::STANDBY_MS_10;
+	sensor.setSettings(settings);
+
+	uint32_t nominal = BME280samplePeriod(settings);
+	sensor_period = nominal * SENSOR_PERIOD_SCALE;
+	sensor_measurement = (nominal - 10000) * SENSOR_PERIOD_SCALE;
+	printf("sensor period %.0f us, nominal %lu us\n", sensor_period, (unsigned long)nominal);
+
+	report("idle bus", run(sensor, false) );
+	report("display load", run(sensor, true) );
+
+	printf("%u failures\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,15 @@
+#ifndef STUB_AVR_INTERRUPT_H
+#define STUB_AVR_INTERRUPT_H
+
+// Host build: an ISR is a plain function the test calls
+
+#ifdef __cplusplus
+#define ISR(vector, ...)        extern "C" void vector(void)
+#else
+#define ISR(vector, ...)        void vector(void)
+#endif
+
+#define sei()
+#define cli()
+
+#endif // STUB_AVR_INTERRUPT_H
@@ -0,0 +1,39 @@
+#ifndef STUB_AVR_IO_H
+#define STUB_AVR_IO_H
+
+// Host build: integer types, and TWI registers for twimaster_test.cpp.
+// TWCR and TWSR are accessed through hooks that play the hardware: any
+// pending START/STOP completes and TWINT is set at once, the status is
+// taken from a script of the test.
+
+#include <stdint.h>
+
+#define _BV(bit)                (1 << (bit))
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+extern volatile uint8_t twi_twbr;
+extern volatile uint8_t twi_twsr;
+extern volatile uint8_t twi_twdr;
+extern volatile uint8_t twi_twcr;
+volatile uint8_t *twi_twcr_access(void);
+volatile uint8_t *twi_twsr_access(void);
+#ifdef __cplusplus
+}
+#endif
+
+#define TWBR                    twi_twbr
+#define TWSR                    (*twi_twsr_access())
+#define TWDR                    twi_twdr
+#define TWCR                    (*twi_twcr_access())
+
+#define TWINT                   7
+#define TWEA                    6
+#define TWSTA                   5
+#define TWSTO                   4
+#define TWWC                    3
+#define TWEN                    2
+#define TWIE                    0
+
+#endif // STUB_AVR_IO_H
@@ -0,0 +1,21 @@
+#ifndef STUB_AVR_PGMSPACE_H
+#define STUB_AVR_PGMSPACE_H
+
+// Host build: PROGMEM data lives in RAM, reads are plain loads
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s)                 (s)
+
+#define pgm_read_byte(address)  (*(const uint8_t *)(address))
+#define pgm_read_word(address)  (*(const uint16_t *)(address))
+#define pgm_read_dword(address) (*(const uint32_t *)(address))
+#define pgm_read_ptr(address)   (*(void * const *)(address))
+
+#define memcpy_P                memcpy
+#define strlen_P                strlen
+#define printf_P                printf
+
+#endif // STUB_AVR_PGMSPACE_H
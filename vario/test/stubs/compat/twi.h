@@ -0,0 +1,25 @@
+#ifndef STUB_COMPAT_TWI_H
+#define STUB_COMPAT_TWI_H
+
+// Host build: master mode status codes of avr-libc util/twi.h
+
+#include <avr/io.h>
+
+#define TW_START                0x08
+#define TW_REP_START            0x10
+#define TW_MT_SLA_ACK           0x18
+#define TW_MT_SLA_NACK          0x20
+#define TW_MT_DATA_ACK          0x28
+#define TW_MT_DATA_NACK         0x30
+#define TW_MT_ARB_LOST          0x38
+#define TW_MR_ARB_LOST          0x38
+#define TW_MR_SLA_ACK           0x40
+#define TW_MR_SLA_NACK          0x48
+#define TW_MR_DATA_ACK          0x50
+#define TW_MR_DATA_NACK         0x58
+#define TW_BUS_ERROR            0x00
+
+#define TW_STATUS_MASK          0xF8
+#define TW_STATUS               (TWSR & TW_STATUS_MASK)
+
+#endif // STUB_COMPAT_TWI_H
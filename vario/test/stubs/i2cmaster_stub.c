@@ -0,0 +1,17 @@
+// Host build: no device answers on the bus
+
+#include "hardware/i2cmaster/i2cmaster.h"
+
+void i2c_init(void) {}
+void i2c_stop(void) {}
+unsigned char i2c_start(unsigned char addr) { return I2C_ERR; }
+unsigned char i2c_rep_start(unsigned char addr) { return I2C_ERR; }
+unsigned char i2c_write(unsigned char data) { return I2C_ERR; }
+unsigned char i2c_readAck(void) { return 0; }
+unsigned char i2c_readNak(void) { return 0; }
+
+unsigned char i2c_submit(i2c_transaction *t)
+{
+	t->status = I2C_ERR;
+	return I2C_ERR;
+}
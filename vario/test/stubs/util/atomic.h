@@ -0,0 +1,10 @@
+#ifndef STUB_UTIL_ATOMIC_H
+#define STUB_UTIL_ATOMIC_H
+
+// Host build: single threaded, atomic blocks run once as they are
+
+#define ATOMIC_BLOCK(type)      for(uint8_t _done = 0; !_done; _done = 1)
+#define ATOMIC_RESTORESTATE
+#define ATOMIC_FORCEON
+
+#endif // STUB_UTIL_ATOMIC_H
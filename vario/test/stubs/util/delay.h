@@ -0,0 +1,9 @@
+#ifndef STUB_UTIL_DELAY_H
+#define STUB_UTIL_DELAY_H
+
+// Host build: delays return immediately
+
+static inline void _delay_ms(double ms) { (void)ms; }
+static inline void _delay_us(double us) { (void)us; }
+
+#endif // STUB_UTIL_DELAY_H
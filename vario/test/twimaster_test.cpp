@@ -0,0 +1,130 @@
+// Hand-off between blocking calls and the interrupt driven engine of
+// twimaster.c, with the TWI registers of stubs/avr/io.h. A transaction
+// submitted after a failed i2c_start() must run, also when the caller
+// follows the failure with i2c_stop() as the blocking API asks.
+
+#include <stdio.h>
+
+#include "hardware/i2cmaster/i2cmaster.h"
+#include <compat/twi.h>
+
+#define DEVICE_ADDR      0x76
+
+extern "C" void TWI_vect(void);
+
+volatile uint8_t twi_twbr = 0;
+volatile uint8_t twi_twsr = 0;
+volatile uint8_t twi_twdr = 0;
+volatile uint8_t twi_twcr = 0;
+
+// Status returned by successive TWSR accesses, the last one is kept
+static const uint8_t *status_script = 0;
+static uint8_t status_left = 0;
+
+volatile uint8_t *twi_twcr_access(void)
+{
+	twi_twcr &= ~(1 << TWSTO);
+	twi_twcr |= (1 << TWINT);
+	return &twi_twcr;
+}
+
+volatile uint8_t *twi_twsr_access(void)
+{
+	if(status_left)
+	{
+		twi_twsr = *status_script++;
+		status_left--;
+	}
+	return &twi_twsr;
+}
+
+template <uint8_t N>
+static void script(const uint8_t (&status)[N])
+{
+	status_script = status;
+	status_left = N;
+}
+
+static uint16_t failures = 0;
+
+static void check(const char *name, bool ok)
+{
+	if(!ok) failures++;
+	printf("%s %s\n", ok ? "  ok" : "FAIL", name);
+}
+
+static bool engine_started()
+{
+	return (twi_twcr & (1 << TWIE)) && (twi_twcr & (1 << TWSTA));
+}
+
+// Drive the ISR through a one byte write as the hardware would
+static void run_write(i2c_transaction &t)
+{
+	static const uint8_t status[] = { TW_START, TW_MT_SLA_ACK, TW_MT_DATA_ACK };
+	script(status);
+
+	TWI_vect();
+	check("address sent by engine", twi_twdr == (DEVICE_ADDR << 1 | I2C_WRITE));
+
+	TWI_vect();
+	check("data sent by engine", twi_twdr == t.tx_data[0]);
+
+	TWI_vect();
+	check("transaction done", t.status == I2C_OK);
+	check("engine idle", !i2c_busy() && !(twi_twcr & (1 << TWIE)) );
+}
+
+template <uint8_t N>
+static void failed_start(const char *name, const uint8_t (&status)[N])
+{
+	const uint8_t data = 0xA5;
+	i2c_transaction t = { DEVICE_ADDR, &data, 1, 0, 0, I2C_OK, 0 };
+
+	printf("%s\n", name);
+
+	twi_twcr = 0;
+	script(status);
+	check("i2c_start fails", i2c_start( (DEVICE_ADDR << 1) | I2C_WRITE) == 1);
+
+	check("submit accepted", i2c_submit(&t) == I2C_OK);
+	check("engine started", engine_started() );
+
+	// Caller cleanup must not stop the engine that owns the bus now
+	i2c_stop();
+	check("i2c_stop after failure keeps engine", engine_started() );
+
+	run_write(t);
+}
+
+int main()
+{
+	i2c_init();
+
+	static const uint8_t address_nack[] = { TW_START, TW_MT_SLA_NACK };
+	static const uint8_t start_error[] = { TW_BUS_ERROR };
+	failed_start("address not acked", address_nack);
+	failed_start("start not sent", start_error);
+
+	// Held back while the bus is claimed, started by i2c_stop()
+	{
+		const uint8_t data = 0x5A;
+		i2c_transaction t = { DEVICE_ADDR, &data, 1, 0, 0, I2C_OK, 0 };
+
+		printf("queued behind blocking transfer\n");
+
+		static const uint8_t address_ack[] = { TW_START, TW_MT_SLA_ACK };
+		twi_twcr = 0;
+		script(address_ack);
+		check("i2c_start succeeds", i2c_start( (DEVICE_ADDR << 1) | I2C_WRITE) == 0);
+		check("submit accepted", i2c_submit(&t) == I2C_OK);
+		check("engine waits for i2c_stop", !engine_started() );
+		i2c_stop();
+		check("engine started by i2c_stop", engine_started() );
+
+		run_write(t);
+	}
+
+	printf("%u failures\n", failures);
+	return failures ? 1 : 0;
+}